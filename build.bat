@@ -2,21 +2,29 @@
 
 set COMPILE_AND_RUN_ASSET_PACKER=0
 
+rem NOTE: The packer generates src/preload_pak.hpp, which isn't checked in, so a fresh clone always has to run it once!!
+IF NOT EXIST src\preload_pak.hpp (
+	echo src/preload_pak.hpp is missing, building and running the asset packer
+	set COMPILE_AND_RUN_ASSET_PACKER=1
+)
+
 IF NOT EXIST bin mkdir bin
 cd bin
 
 IF %COMPILE_AND_RUN_ASSET_PACKER%==1 (
 	cl -MTd -Od -Z7 -nologo -Feasset_packer -EHa- -Gm- -GR- -fp:fast -Oi -WX -W4 -wd4996 -wd4100 -wd4189 -wd4127 -wd4201 -DWIN32=1 -DDEBUG_ENABLED=1 -DASSERTIONS_ENABLED=1 -I../lib -I../src ../src/asset_packer.cpp shell32.lib user32.lib gdi32.lib -link
 	cd ../dat
+	rem NOTE: Also generates src/preload_pak.hpp!!
 	"../bin/asset_packer.exe"
-	"C:\Program Files\7-zip\7z" a pak/preload.zip preload.pak > NUL: && del "preload.pak"
-	"C:\Program Files\7-zip\7z" a pak/map.zip map.pak > NUL: && del "map.pak"
-	"C:\Program Files\7-zip\7z" a pak/texture.zip texture.pak > NUL: && del "texture.pak"
-	rem "C:\Program Files\7-zip\7z" a pak/audio.zip audio.pak > NUL: && del "audio.pak"
-	"C:\Program Files\7-zip\7z" a pak/atlas.zip atlas.pak > NUL: && del "atlas.pak"
 	cd ../bin
 )
 
+IF NOT EXIST ..\src\preload_pak.hpp (
+	echo error: src/preload_pak.hpp is missing, the asset packer has to run before the game can build
+	cd ..
+	exit /b 1
+)
+
 set COMMON_COMPILER_FLAGS=-s TOTAL_MEMORY=134217728 -std=c++11 -Werror -Wall -Wno-missing-braces -Wno-unused-variable -Wno-unused-function -DDEBUG_ENABLED=1 -DASSERTIONS_ENABLED=0 -DDEV_ENABLED=0
 
 rem set COMPILER_FLAGS=%COMMON_COMPILER_FLAGS% -s SAFE_HEAP=0
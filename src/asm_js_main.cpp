@@ -3,7 +3,9 @@
 #include <emscripten/html5.h>
 
 #include <SDL/SDL.h>
+#define GL_GLEXT_PROTOTYPES 1
 #include <SDL/SDL_opengl.h>
+#include <GLES2/gl2ext.h>
 
 #include <sys.hpp>
 
@@ -249,12 +251,14 @@ int main_init() {
 
 	if(web_audio_init(args.channels, 2048, &args.samples_per_second, (void *)audio_callback, &args)) {
 		args.game_input.audio_supported = true;
+		args.game_input.audio_samples_per_second = args.samples_per_second;
 		async_audio_request(0);
 
 		emscripten_SDL_SetAudioFixCallback((void *)audio_fix_callback);
 	}
 	else {
 		args.game_input.audio_supported = false;
+		args.game_input.audio_samples_per_second = 0;
 	}
 
 	args.frame_time = emscripten_get_now();
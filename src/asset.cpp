@@ -8,8 +8,17 @@
 #endif
 
 #define MINIZ_NO_TIME
+#define MINIZ_NO_ARCHIVE_APIS
 #include <miniz.c>
 
+//NOTE: Generated by the asset packer and not checked in, build.bat runs the packer when it's missing!!
+#if defined(__has_include)
+#if !__has_include(<preload_pak.hpp>)
+#error "src/preload_pak.hpp is missing, run the asset packer from dat (build.bat does this when the header is absent)"
+#endif
+#endif
+#include <preload_pak.hpp>
+
 #define STB_VORBIS_NO_PUSHDATA_API
 #include <stb_vorbis.c>
 
@@ -73,104 +82,401 @@ Asset * push_asset(AssetState * assets, AssetId id, AssetType type) {
 	return asset;
 }
 
-void process_asset_file(AssetState * assets, AssetFile asset_file) {
-	//TODO: Pull this out!!
-	if(asset_file.type == AssetFileType_pak) {
-		MemoryPtr file_buf;
-		//TODO: Can we just get the first archive??
-		file_buf.ptr = (u8 *)mz_zip_extract_archive_file_to_heap(asset_file.file_name, asset_file.archive_name, &file_buf.size, 0);
-		u8 * file_ptr = file_buf.ptr;
+AudioResampleKernel * get_audio_resample_kernel(AssetState * assets, f32 cutoff) {
+	//NOTE: One table per cutoff, there's only ever a couple of source rates so these are never thrown away!!
+	for(u32 i = 0; i < assets->audio_resample_kernel_count; i++) {
+		AudioResampleKernel * kernel = assets->audio_resample_kernels + i;
+		if(kernel->cutoff == cutoff) {
+			return kernel;
+		}
+	}
 
-		assets->debug_total_size += file_buf.size;
+	ASSERT(assets->audio_resample_kernel_count < ARRAY_COUNT(assets->audio_resample_kernels));
+	AudioResampleKernel * kernel = assets->audio_resample_kernels + assets->audio_resample_kernel_count++;
+
+	//NOTE: Blackman windowed sinc, widened when downsampling so the window still covers the lowered cutoff!!
+	kernel->cutoff = cutoff;
+	kernel->half_taps = (u32)math::ceil_to_i32((f32)AUDIO_RESAMPLE_TAPS / cutoff);
+
+	u32 taps = kernel->half_taps * 2;
+	kernel->weights = PUSH_ARRAY(assets->arena, f32, (AUDIO_RESAMPLE_PHASES + 1) * taps, false);
+
+	for(u32 phase = 0; phase <= AUDIO_RESAMPLE_PHASES; phase++) {
+		f32 frac = (f32)phase / (f32)AUDIO_RESAMPLE_PHASES;
+		f32 * row = kernel->weights + phase * taps;
+
+		f32 weight = 0.0f;
+		for(u32 i = 0; i < taps; i++) {
+			f32 x = (f32)((i32)i - ((i32)kernel->half_taps - 1)) - frac;
+			f32 w = math::clamp01((x + kernel->half_taps) / (f32)taps);
+			f32 window = 0.42f - 0.5f * math::cos(math::TAU * w) + 0.08f * math::cos(2.0f * math::TAU * w);
+
+			f32 x_cutoff = x * cutoff;
+			row[i] = window;
+			if(math::abs(x_cutoff) > 0.00001f) {
+				row[i] *= math::sin(math::PI * x_cutoff) / (math::PI * x_cutoff);
+			}
+
+			weight += row[i];
+		}
+
+		for(u32 i = 0; i < taps; i++) {
+			row[i] /= weight;
+		}
+	}
+
+	return kernel;
+}
+
+AudioResample * push_audio_resample(AssetState * assets, AudioClip * clip, u32 samples_per_second, b32 free_src) {
+	ASSERT(clip->samples_per_second && samples_per_second);
+	ASSERT(assets->audio_resample_count < ARRAY_COUNT(assets->audio_resamples));
+
+	u32 index = (assets->first_audio_resample + assets->audio_resample_count++) % ARRAY_COUNT(assets->audio_resamples);
+	AudioResample * resample = assets->audio_resamples + index;
+
+	resample->step = (f64)clip->samples_per_second / (f64)samples_per_second;
+	resample->kernel = get_audio_resample_kernel(assets, resample->step > 1.0 ? (f32)(1.0 / resample->step) : 1.0f);
+	resample->samples_per_second = samples_per_second;
+
+	resample->src = clip->sample_data;
+	resample->src_count = clip->samples + AUDIO_PADDING_SAMPLES;
+	resample->free_src = free_src;
+
+	resample->dst_count = (u32)((f64)resample->src_count / resample->step);
+	ASSERT(resample->dst_count > AUDIO_PADDING_SAMPLES);
+	resample->dst = ALLOC_ARRAY(i16, resample->dst_count * clip->channels, false);
+	resample->dst_index = 0;
+
+	resample->clip = clip;
+	clip->ready = false;
+
+	return resample;
+}
+
+void resample_audio_chunk(AudioResample * resample, u32 dst_begin, u32 dst_end) {
+	AudioResampleKernel * kernel = resample->kernel;
+	u32 taps = kernel->half_taps * 2;
+	u32 channels = resample->clip->channels;
+
+	i16 const * src = resample->src;
+	i16 * dst = resample->dst;
+	u32 src_count = resample->src_count;
+
+	for(u32 i = dst_begin; i < dst_end; i++) {
+		f64 src_pos = (f64)i * resample->step;
+		i32 src_index = (i32)src_pos;
+		u32 phase = (u32)((src_pos - src_index) * AUDIO_RESAMPLE_PHASES + 0.5);
+		f32 * row = kernel->weights + phase * taps;
+
+		for(u32 c = 0; c < channels; c++) {
+			f32 sample = 0.0f;
+			for(u32 t = 0; t < taps; t++) {
+				i32 j = src_index + (i32)t - ((i32)kernel->half_taps - 1);
+				j = j < 0 ? 0 : (j >= (i32)src_count ? (i32)src_count - 1 : j);
+
+				sample += (f32)src[j * channels + c] * row[t];
+			}
+
+			sample = math::clamp(sample, -32768.0f, 32767.0f);
+			dst[i * channels + c] = (i16)(sample + (sample > 0.0f ? 0.5f : -0.5f));
+		}
+	}
+}
+
+void process_audio_resamples(AssetState * assets, b32 flush = false) {
+	DEBUG_TIME_BLOCK();
+
+	f64 begin_timestamp = emscripten_get_now();
+
+	while(assets->audio_resample_count) {
+		AudioResample * resample = assets->audio_resamples + assets->first_audio_resample;
+
+		//NOTE: Always do at least one chunk so long clips still make progress!!
+		u32 samples = resample->dst_count - resample->dst_index;
+		if(!flush) {
+			samples = MIN(samples, AUDIO_RESAMPLE_SAMPLES_PER_CHUNK);
+		}
+
+		resample_audio_chunk(resample, resample->dst_index, resample->dst_index + samples);
+		resample->dst_index += samples;
+
+		if(resample->dst_index >= resample->dst_count) {
+			//NOTE: The clip keeps its source data and stays unplayable until the whole thing is done!!
+			AudioClip * clip = resample->clip;
+			clip->samples = resample->dst_count - AUDIO_PADDING_SAMPLES;
+			clip->samples_per_second = resample->samples_per_second;
+			clip->sample_data = resample->dst;
+			clip->ready = true;
+
+			if(resample->free_src) {
+				std::free((void *)resample->src);
+			}
+
+			assets->first_audio_resample = (assets->first_audio_resample + 1) % ARRAY_COUNT(assets->audio_resamples);
+			assets->audio_resample_count--;
+		}
+
+		if(!flush && (emscripten_get_now() - begin_timestamp) >= AUDIO_RESAMPLE_MS_PER_FRAME) {
+			break;
+		}
+	}
+}
+
+void push_texture_upload(AssetState * assets, gl::Texture gl_tex, u8 const * data, GLenum format, GLenum type, u32 mip_levels) {
+	ASSERT(assets->texture_upload_count < ARRAY_COUNT(assets->texture_uploads));
+
+	u32 index = (assets->first_texture_upload + assets->texture_upload_count++) % ARRAY_COUNT(assets->texture_uploads);
+	TextureUpload * upload = assets->texture_uploads + index;
+	upload->gl_tex = gl_tex;
+	upload->data = data;
+	upload->format = format;
+	upload->type = type;
+	upload->pixel_size = gl::get_pixel_size(format, type);
+	upload->mip_levels = mip_levels;
+	upload->level = 0;
+	upload->row = 0;
+}
+
+void process_texture_uploads(AssetState * assets, b32 flush = false) {
+	DEBUG_TIME_BLOCK();
+
+	f64 begin_timestamp = emscripten_get_now();
+	u32 bytes_left = TEXTURE_UPLOAD_BYTES_PER_FRAME;
+
+	while(assets->texture_upload_count) {
+		TextureUpload * upload = assets->texture_uploads + assets->first_texture_upload;
+
+		u32 level_width = get_texture_mip_dim(upload->gl_tex.width, upload->level);
+		u32 level_height = get_texture_mip_dim(upload->gl_tex.height, upload->level);
+		u32 row_size = level_width * upload->pixel_size;
+
+		//NOTE: Always upload at least one row so large textures still make progress!!
+		u32 rows = level_height - upload->row;
+		if(!flush) {
+			rows = MIN(rows, MAX(bytes_left / row_size, 1));
+		}
+
+		gl::upload_texture_rows(&upload->gl_tex, upload->level, upload->row, rows, upload->data, upload->format, upload->type);
 
-		AssetPackHeader * pack = (AssetPackHeader *)file_ptr;
-		file_ptr += sizeof(AssetPackHeader);
-	 
-		for(u32 i = 0; i < pack->asset_count; i++) {
-			AssetInfo * asset_info = (AssetInfo *)file_ptr;
-			file_ptr += sizeof(AssetInfo);
+		u32 strip_size = rows * row_size;
+		upload->data += strip_size;
+		upload->row += rows;
+		bytes_left = bytes_left > strip_size ? bytes_left - strip_size : 0;
 
-			switch(asset_info->type) {
-				case AssetType_texture: {
-					TextureInfo * info = &asset_info->texture;
+		if(upload->row >= level_height) {
+			upload->row = 0;
+			upload->level++;
 
+			if(upload->level >= upload->mip_levels) {
+				//NOTE: Mark aliases of this texture too!!
+				for(u32 i = 0; i < assets->asset_count; i++) {
+					Asset * asset = assets->assets + i;
+					if(asset->type == AssetType_texture && asset->texture.gl_id == upload->gl_tex.id) {
+						asset->texture.ready = true;
+					}
+				}
+
+				assets->first_texture_upload = (assets->first_texture_upload + 1) % ARRAY_COUNT(assets->texture_uploads);
+				assets->texture_upload_count--;
+			}
+		}
+
+		if(!flush && (!bytes_left || (emscripten_get_now() - begin_timestamp) >= TEXTURE_UPLOAD_MS_PER_FRAME)) {
+			break;
+		}
+	}
+}
+
+b32 texture_is_ready(AssetState * assets, Asset * asset) {
+	b32 ready = false;
+	if(asset->type == AssetType_texture) {
+		ready = asset->texture.ready;
+	}
+	else {
+		ASSERT(asset->type == AssetType_sprite);
+		ready = get_texture_asset(assets, AssetId_atlas, asset->sprite.atlas_index)->ready;
+	}
+
+	return ready;
+}
+
+//NOTE: Blocks are independent so this could be split across workers/frames, there's only the one thread for now!!
+MemoryPtr read_compressed_asset_pack(char const * file_name) {
+	MemoryPtr file_buf = {};
+
+	MemoryPtr compressed_buf = read_file_to_memory(file_name);
+	ASSERT(compressed_buf.ptr);
+
+	CompressedAssetPackHeader * header = (CompressedAssetPackHeader *)compressed_buf.ptr;
+	u32 * block_compressed_sizes = (u32 *)(header + 1);
+	u8 * block_ptr = (u8 *)(block_compressed_sizes + header->block_count);
+
+	file_buf.size = header->size;
+	file_buf.ptr = ALLOC_MEMORY(u8, file_buf.size, false);
+
+	for(u32 i = 0; i < header->block_count; i++) {
+		size_t block_offset = (size_t)i * header->block_size;
+		size_t block_size = MIN(header->block_size, header->size - block_offset);
+
+		size_t result = tinfl_decompress_mem_to_mem(file_buf.ptr + block_offset, block_size, block_ptr, block_compressed_sizes[i], 0);
+		ASSERT(result == block_size);
+
+		block_ptr += block_compressed_sizes[i];
+	}
+
+	FREE_MEMORY(compressed_buf.ptr);
+
+	return file_buf;
+}
+
+//NOTE: Everything in the pak points straight into the buffer so it has to outlive the assets!!
+void process_asset_pack(AssetState * assets, u8 const * pak_ptr) {
+	u8 const * file_ptr = pak_ptr;
+
+	AssetPackHeader const * pack = (AssetPackHeader const *)file_ptr;
+	file_ptr += sizeof(AssetPackHeader);
+ 
+	for(u32 i = 0; i < pack->asset_count; i++) {
+		AssetInfo const * asset_info = (AssetInfo const *)file_ptr;
+		file_ptr += sizeof(AssetInfo);
+
+		switch(asset_info->type) {
+			case AssetType_texture: {
+				TextureInfo const * info = &asset_info->texture;
+
+				if(info->alias_id != AssetId_null) {
+					//NOTE: Aliases share the GL texture (and upload) of an identical texture earlier in the pak!!
+					Texture * alias_tex = get_texture_asset(assets, info->alias_id, info->alias_index);
+					ASSERT(alias_tex);
+
+					Asset * asset = push_asset(assets, asset_info->id, AssetType_texture);
+					asset->texture = *alias_tex;
+				}
+				else {
 					i32 filter = GL_LINEAR;
 					if(info->sampling == TextureSampling_point) {
 						filter = GL_NEAREST;
 					}
 					else {
-						ASSERT(info->sampling == TextureSampling_bilinear);
+						ASSERT(info->sampling == TextureSampling_bilinear || info->sampling == TextureSampling_sdf);
 					}
 
-					gl::Texture gl_tex = gl::create_texture(file_ptr, info->width, info->height, GL_RGBA, filter, GL_CLAMP_TO_EDGE);
+					GLenum format = GL_RGBA;
+					GLenum type = GL_UNSIGNED_BYTE;
+					if(info->format == TextureFormat_rgb565) {
+						format = GL_RGB;
+						type = GL_UNSIGNED_SHORT_5_6_5;
+						//NOTE: Packed 16 bit pixels are read through a u16 view on the web!!
+						ASSERT(((size_t)file_ptr & 1) == 0);
+					}
+					else if(info->format == TextureFormat_luminance_alpha) {
+						format = GL_LUMINANCE_ALPHA;
+					}
+					else {
+						ASSERT(info->format == TextureFormat_rgba8);
+					}
+
+					ASSERT(info->mip_levels);
+					gl::Texture gl_tex = gl::allocate_texture(info->width, info->height, format, type, filter, GL_CLAMP_TO_EDGE, info->mip_levels);
 
 					Asset * asset = push_asset(assets, asset_info->id, AssetType_texture);
 					asset->texture.dim = math::vec2(info->width, info->height);
 					asset->texture.offset = math::vec2(0.0f);
 					asset->texture.gl_id = gl_tex.id;
+					asset->texture.ready = false;
+					asset->texture.sdf = info->sampling == TextureSampling_sdf;
 
-					file_ptr += info->width * info->height * TEXTURE_CHANNELS;
+					//NOTE: Pixel data stays in the pak buffer until the upload queue gets to it!!
+					push_texture_upload(assets, gl_tex, file_ptr, format, type, info->mip_levels);
 
-					break;
+					file_ptr += get_texture_size(info->width, info->height, info->format, info->mip_levels);
 				}
 
-				case AssetType_sprite: {
-					SpriteInfo * info = &asset_info->sprite;
+				break;
+			}
 
-					Asset * asset = push_asset(assets, asset_info->id, AssetType_sprite);
-					asset->sprite.dim = math::vec2(info->width, info->height);
-					asset->sprite.offset = info->offset;
-					asset->sprite.tex_coords[0] = info->tex_coords[0];
-					asset->sprite.tex_coords[1] = info->tex_coords[1];
-					asset->sprite.atlas_index = info->atlas_index;
+			case AssetType_sprite: {
+				SpriteInfo const * info = &asset_info->sprite;
 
-					break;
-				}
+				Asset * asset = push_asset(assets, asset_info->id, AssetType_sprite);
+				asset->sprite.dim = math::vec2(info->width, info->height);
+				asset->sprite.offset = info->offset;
+				asset->sprite.tex_coords[0] = info->tex_coords[0];
+				asset->sprite.tex_coords[1] = info->tex_coords[1];
+				asset->sprite.atlas_index = info->atlas_index;
+				asset->sprite.rotated = info->rotated;
+				asset->sprite.mesh_vert_count = info->mesh_vert_count;
+				asset->sprite.mesh_verts = (math::Vec2 const *)file_ptr;
 
-				case AssetType_audio_clip: {
-					AudioClipInfo * info = (AudioClipInfo *)&asset_info->audio_clip;
+				file_ptr += sizeof(math::Vec2) * info->mesh_vert_count;
+
+				break;
+			}
 
-					Asset * asset = push_asset(assets, asset_info->id, AssetType_audio_clip);
-					asset->audio_clip.samples = info->samples;
-					asset->audio_clip.sample_data = (i16 *)file_ptr;
+			case AssetType_audio_clip: {
+				AudioClipInfo const * info = (AudioClipInfo const *)&asset_info->audio_clip;
 
-					file_ptr += info->size;
+				Asset * asset = push_asset(assets, asset_info->id, AssetType_audio_clip);
+				asset->audio_clip.samples = info->samples;
+				asset->audio_clip.channels = info->channels;
+				asset->audio_clip.samples_per_second = AUDIO_SAMPLE_RATE;
+				asset->audio_clip.sample_data = (i16 const *)file_ptr;
+				asset->audio_clip.ready = true;
 
-					break;
+				if(assets->audio_samples_per_second && assets->audio_samples_per_second != AUDIO_SAMPLE_RATE) {
+					push_audio_resample(assets, &asset->audio_clip, assets->audio_samples_per_second, false);
 				}
 
-				case AssetType_tile_map: {
-					TileMapInfo * info = &asset_info->tile_map;
+				file_ptr += info->size;
 
-					Asset * asset = push_asset(assets, asset_info->id, AssetType_tile_map);
-					asset->tile_map.width = info->width;
-					asset->tile_map.tiles = (Tiles *)file_ptr;
+				break;
+			}
 
-					file_ptr += info->width * sizeof(Tiles);
+			case AssetType_tile_map: {
+				TileMapInfo const * info = &asset_info->tile_map;
 
-					break;
-				}
+				Asset * asset = push_asset(assets, asset_info->id, AssetType_tile_map);
+				asset->tile_map.width = info->width;
+				asset->tile_map.spawn_count = info->spawn_count;
+				asset->tile_map.column_offsets = (u32 const *)file_ptr;
+				asset->tile_map.spawns = (TileSpawn const *)(file_ptr + sizeof(u32) * (info->width + 1));
 
-				case AssetType_font: {
-					FontInfo * info = &asset_info->font;
+				file_ptr += get_tile_map_size(info->width, info->spawn_count);
 
-					Asset * asset = push_asset(assets, asset_info->id, AssetType_font);
-					asset->font.glyphs = (FontGlyph *)file_ptr;
-					asset->font.glyph_id = info->glyph_id;
-					asset->font.ascent = info->ascent;
-					asset->font.descent = info->descent;
-					asset->font.whitespace_advance = info->whitespace_advance;
-					asset->font.atlas_index = info->atlas_index;
+				break;
+			}
 
-					file_ptr += sizeof(FontGlyph) * FONT_GLYPH_COUNT;
+			case AssetType_font: {
+				FontInfo const * info = &asset_info->font;
 
-					break;
-				}
+				Asset * asset = push_asset(assets, asset_info->id, AssetType_font);
+				asset->font.glyphs = (FontGlyph const *)file_ptr;
+				asset->font.glyph_id = info->glyph_id;
+				asset->font.ascent = info->ascent;
+				asset->font.descent = info->descent;
+				asset->font.whitespace_advance = info->whitespace_advance;
+				asset->font.atlas_index = info->atlas_index;
+				asset->font.glyph_scale = info->glyph_scale;
 
-				INVALID_CASE();
+				file_ptr += sizeof(FontGlyph) * FONT_GLYPH_COUNT;
+
+				break;
 			}
+
+			INVALID_CASE();
 		}
 	}
+}
+
+void process_asset_file(AssetState * assets, AssetFile asset_file) {
+	//TODO: Pull this out!!
+	if(asset_file.type == AssetFileType_pak) {
+		MemoryPtr file_buf = read_compressed_asset_pack(asset_file.file_name);
+		assets->debug_total_size += file_buf.size;
+
+		process_asset_pack(assets, file_buf.ptr);
+	}
 	else {
 		ASSERT(asset_file.type == AssetFileType_one);
 
@@ -178,24 +484,46 @@ void process_asset_file(AssetState * assets, AssetFile asset_file) {
 		i16 * samples;
 		i32 sample_count = stb_vorbis_decode_filename(asset_file.file_name, &channels, &sample_rate, &samples);
 		ASSERT(sample_count);
-		ASSERT(channels == AUDIO_CHANNELS);
-		ASSERT(sample_rate == AUDIO_SAMPLE_RATE)
+		//NOTE: Mono clips are kept mono and panned at mix time!!
+		ASSERT(channels == 1 || channels == AUDIO_CHANNELS);
+		ASSERT(sample_rate);
 
 		Asset * asset = push_asset(assets, asset_file.asset_id, AssetType_audio_clip);
 		//TODO: Need to add the padding sample to the front of the source audio clip!!
 		asset->audio_clip.samples = (u32)(sample_count - AUDIO_PADDING_SAMPLES);
+		asset->audio_clip.channels = (u32)channels;
+		asset->audio_clip.samples_per_second = (u32)sample_rate;
 		asset->audio_clip.sample_data = samples;
+		asset->audio_clip.ready = true;
 
-		assets->debug_total_size += (u32)sample_count * channels * sizeof(i16);
+		//NOTE: Resample once here so the mixer can play unpitched clips without interpolating!!
+		if(assets->audio_samples_per_second && assets->audio_samples_per_second != (u32)sample_rate) {
+			AudioResample * resample = push_audio_resample(assets, &asset->audio_clip, assets->audio_samples_per_second, true);
+			assets->debug_total_size += resample->dst_count * channels * sizeof(i16);
+		}
+		else {
+			assets->debug_total_size += (asset->audio_clip.samples + AUDIO_PADDING_SAMPLES) * channels * sizeof(i16);
+		}
 	}
 }
 
-void load_assets(AssetState * assets, MemoryArena * arena) {
+void load_assets(AssetState * assets, MemoryArena * arena, u32 audio_samples_per_second) {
 	DEBUG_TIME_BLOCK();
 	
 	assets->arena = arena;
+	assets->audio_samples_per_second = audio_samples_per_second;
 
-	process_asset_file(assets, asset_file_pak((char *)"pak/preload.zip", (char *)"preload.pak"));
+	f64 begin_preload_timestamp = emscripten_get_now();
+
+	//NOTE: Compiled in so the loading screen doesn't have to wait on any file io or inflating!!
+	process_asset_pack(assets, preload_pak);
+	assets->debug_total_size += sizeof(preload_pak);
+
+	//NOTE: The loading screen needs these straight away!!
+	process_texture_uploads(assets, true);
+	process_audio_resamples(assets, true);
+
+	assets->debug_preload_time = (f32)(emscripten_get_now() - begin_preload_timestamp);
 
 #if DEV_ENABLED
 	for(u32 i = 0; i < ARRAY_COUNT(global_dev_asset_files); i++) {
@@ -210,28 +538,7 @@ void load_assets(AssetState * assets, MemoryArena * arena) {
 			ASSERT(height = TILE_MAP_HEIGHT);
 
 			Asset * asset = push_asset(assets, asset_file.asset_id, AssetType_tile_map);
-			asset->tile_map.width = (u32)width;
-			asset->tile_map.tiles = ALLOC_ARRAY(Tiles, (u32)width);
-
-			for(u32 x = 0; x < (u32)width; x++) {
-				Tiles * tiles = asset->tile_map.tiles + x;
-
-				for(u32 y = 0; y < TILE_MAP_HEIGHT; y++) {
-					u32 i = (y * (u32)width + x) * channels;
-					ColorRGB8 color = color_rgb8(img_data[i + 0], img_data[i + 1], img_data[i + 2]);
-
-					TileId id = TileId_null;
-					for(u32 ii = 0; ii < ARRAY_COUNT(tile_id_color_table); ii++) {
-						TileIdColorRGB8 id_color = tile_id_color_table[ii];
-						if(colors_are_equal(color, id_color.color)) {
-							id = id_color.id;
-							break;
-						}
-					}
-
-					tiles->ids[y] = id;
-				}
-			}
+			asset->tile_map = create_tile_map(img_data, (u32)width, (u32)channels);
 
 			stbi_image_free(img_data);
 		}
@@ -300,24 +607,26 @@ b32 process_next_asset_file(AssetState * assets) {
 		asset_file_one((char *)"audio/game_music.ogg", AssetId_game_music),
 		asset_file_one((char *)"audio/space_music.ogg", AssetId_space_music),
 
-		asset_file_pak((char *)"pak/map.zip", (char *)"map.pak"),
-		asset_file_pak((char *)"pak/texture.zip", (char *)"texture.pak"),
-		asset_file_pak((char *)"pak/atlas.zip", (char *)"atlas.pak"),
+		asset_file_pak((char *)"pak/map.pkz"),
+		asset_file_pak((char *)"pak/texture.pkz"),
+		asset_file_pak((char *)"pak/atlas.pkz"),
 	};
 
-	ASSERT(assets->last_loaded_file_index < ARRAY_COUNT(asset_files));
 	assets->loaded_file_count = ARRAY_COUNT(asset_files);
 
-	f64 begin_load_timestamp = emscripten_get_now();
+	if(assets->last_loaded_file_index < ARRAY_COUNT(asset_files)) {
+		f64 begin_load_timestamp = emscripten_get_now();
 
-	AssetFile asset_file = asset_files[assets->last_loaded_file_index++];
-	process_asset_file(assets, asset_file);
+		AssetFile asset_file = asset_files[assets->last_loaded_file_index++];
+		process_asset_file(assets, asset_file);
 
-	f32 asset_load_time = (f32)(emscripten_get_now() - begin_load_timestamp);
-	assets->debug_load_time += asset_load_time;
-	// std::printf("LOG: %s -> %f\n", asset_file.file_name, asset_load_time);
+		f32 asset_load_time = (f32)(emscripten_get_now() - begin_load_timestamp);
+		assets->debug_load_time += asset_load_time;
+		// std::printf("LOG: %s -> %f\n", asset_file.file_name, asset_load_time);
+	}
 
-	if(assets->last_loaded_file_index >= ARRAY_COUNT(asset_files)) {
+	//NOTE: Not done until the last texture has finished uploading and the last clip has been resampled!!
+	if(assets->last_loaded_file_index >= ARRAY_COUNT(asset_files) && !assets->texture_upload_count && !assets->audio_resample_count) {
 		loaded = true;
 	}
 
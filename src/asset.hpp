@@ -3,6 +3,15 @@
 #define ASSET_HPP_INCLUDED
 
 #include <asset_format.hpp>
+#include <gl.hpp>
+
+//NOTE: Texture uploads are spread across frames, these are per frame limits!!
+#define TEXTURE_UPLOAD_BYTES_PER_FRAME MEGABYTES(1)
+#define TEXTURE_UPLOAD_MS_PER_FRAME 4.0
+
+//NOTE: Same again for resampling audio clips to the device rate!!
+#define AUDIO_RESAMPLE_SAMPLES_PER_CHUNK 4096
+#define AUDIO_RESAMPLE_MS_PER_FRAME 2.0
 
 enum AssetFileType {
 	AssetFileType_pak,
@@ -12,10 +21,7 @@ struct AssetFile {
 	char * file_name;
 
 	AssetFileType type;
-	union {
-		char * archive_name;
-		AssetId asset_id;
-	};
+	AssetId asset_id;
 };
 
 inline AssetFile asset_file_one(char * file_name, AssetId asset_id) {
@@ -26,11 +32,10 @@ inline AssetFile asset_file_one(char * file_name, AssetId asset_id) {
 	return asset_file;
 }
 
-inline AssetFile asset_file_pak(char * file_name, char * archive_name) {
+inline AssetFile asset_file_pak(char * file_name) {
 	AssetFile asset_file = {};
 	asset_file.file_name = file_name;
 	asset_file.type = AssetFileType_pak;
-	asset_file.archive_name = archive_name;
 	return asset_file;
 }
 
@@ -69,19 +74,64 @@ struct Texture {
 	union {
 		struct { 
 			u32 gl_id; 
+			b32 ready;
+			b32 sdf;
 		};
 
 		//NOTE: Sprite
 		struct {
 			math::Vec2 tex_coords[2];
 			u32 atlas_index;
+			b32 rotated;
+
+			u32 mesh_vert_count;
+			math::Vec2 const * mesh_verts;
 		};
 	};
 };
 
 struct AudioClip {
 	u32 samples;
-	i16 * sample_data;
+	u32 channels;
+	u32 samples_per_second;
+	i16 const * sample_data;
+
+	b32 ready;
+};
+
+struct AudioResampleKernel {
+	f32 cutoff;
+	u32 half_taps;
+	f32 * weights;
+};
+
+struct AudioResample {
+	AudioClip * clip;
+	AudioResampleKernel * kernel;
+
+	i16 const * src;
+	u32 src_count;
+	b32 free_src;
+
+	i16 * dst;
+	u32 dst_count;
+	u32 dst_index;
+
+	f64 step;
+	u32 samples_per_second;
+};
+
+struct TextureUpload {
+	gl::Texture gl_tex;
+
+	u8 const * data;
+	GLenum format;
+	GLenum type;
+	u32 pixel_size;
+
+	u32 mip_levels;
+	u32 level;
+	u32 row;
 };
 
 struct Asset {
@@ -110,10 +160,23 @@ struct AssetState {
 	u32 last_loaded_file_index;
 	u32 loaded_file_count;
 
+	u32 audio_samples_per_second;
+	u32 audio_resample_kernel_count;
+	AudioResampleKernel audio_resample_kernels[4];
+
+	u32 first_audio_resample;
+	u32 audio_resample_count;
+	AudioResample audio_resamples[64];
+
+	u32 first_texture_upload;
+	u32 texture_upload_count;
+	TextureUpload texture_uploads[64];
+
 	u32 asset_count;
 	Asset assets[2048];
 	AssetGroup asset_groups[AssetId_count];
 
+	f32 debug_preload_time;
 	f32 debug_load_time;
 	u32 debug_total_size;
 };
@@ -6,18 +6,61 @@
 
 #define TEXTURE_CHANNELS 4
 #define TEXTURE_PADDING_PIXELS 1
+//NOTE: Number of mip levels that are guaranteed not to bleed between sprites in an atlas!!
+#define TEXTURE_MIP_GUTTER_LEVELS 3
+//NOTE: Sprites whose opaque pixels fill most of their rect are still drawn as quads!!
+#define SPRITE_MAX_MESH_VERTS 8
 
 enum TextureSampling {
 	TextureSampling_point,
 	TextureSampling_bilinear,
+	//NOTE: Bilinear, alpha holds a signed distance (0.5 on the edge) rather than coverage!!
+	TextureSampling_sdf,
 
 	TextureSampling_count,
 };
 
+enum TextureFormat {
+	TextureFormat_rgba8,
+	TextureFormat_rgb565,
+	TextureFormat_luminance_alpha,
+
+	TextureFormat_count,
+};
+
+inline u32 get_texture_format_bytes_per_pixel(TextureFormat format) {
+	u32 bytes_per_pixel = TEXTURE_CHANNELS;
+	if(format == TextureFormat_rgb565 || format == TextureFormat_luminance_alpha) {
+		bytes_per_pixel = 2;
+	}
+	else {
+		ASSERT(format == TextureFormat_rgba8);
+	}
+
+	return bytes_per_pixel;
+}
+
+inline u32 get_texture_mip_dim(u32 dim, u32 level) {
+	u32 mip_dim = dim >> level;
+	return mip_dim ? mip_dim : 1;
+}
+
+inline u32 get_texture_size(u32 width, u32 height, TextureFormat format, u32 mip_levels = 1) {
+	u32 size = 0;
+	for(u32 i = 0; i < mip_levels; i++) {
+		size += get_texture_mip_dim(width, i) * get_texture_mip_dim(height, i);
+	}
+
+	return size * get_texture_format_bytes_per_pixel(format);
+}
+
 #define AUDIO_SAMPLE_RATE 44100
 #define AUDIO_PADDING_SAMPLES 1
 #define AUDIO_CHANNELS 2
 
+#define AUDIO_RESAMPLE_TAPS 8
+#define AUDIO_RESAMPLE_PHASES 256
+
 #define TILE_MAP_HEIGHT 37
 
 enum TileId {
@@ -73,19 +116,82 @@ static TileIdColorRGB8 tile_id_color_table[] = {
 };
 
 #pragma pack(push, 1)
-struct Tiles {
-	TileId ids[TILE_MAP_HEIGHT];
+struct TileSpawn {
+	u8 row;
+	u8 id;
 };
 
+//NOTE: Only the non-null tiles are stored, column x spawns spawns[column_offsets[x]] up to spawns[column_offsets[x + 1]]!!
 struct TileMap {
 	u32 width;
-	Tiles * tiles;
+	u32 spawn_count;
+	u32 const * column_offsets;
+	TileSpawn const * spawns;
 };
 #pragma pack(pop)
 
+inline TileId get_tile_id_from_color(ColorRGB8 color) {
+	TileId id = TileId_null;
+	for(u32 i = 0; i < ARRAY_COUNT(tile_id_color_table); i++) {
+		TileIdColorRGB8 id_color = tile_id_color_table[i];
+		if(colors_are_equal(color, id_color.color)) {
+			id = id_color.id;
+			break;
+		}
+	}
+
+	return id;
+}
+
+//NOTE: Spawns are padded to a multiple of 4 bytes in the pak so whatever follows stays aligned!!
+inline u32 get_tile_map_size(u32 width, u32 spawn_count) {
+	return sizeof(u32) * (width + 1) + ALIGN4(sizeof(TileSpawn) * spawn_count);
+}
+
+inline TileMap create_tile_map(u8 const * img_data, u32 width, u32 channels) {
+	TileMap map = {};
+	map.width = width;
+
+	for(u32 i = 0; i < width * TILE_MAP_HEIGHT; i++) {
+		u8 const * pixel = img_data + i * channels;
+		if(get_tile_id_from_color(color_rgb8(pixel[0], pixel[1], pixel[2])) != TileId_null) {
+			map.spawn_count++;
+		}
+	}
+
+	u32 * column_offsets = ALLOC_ARRAY(u32, width + 1);
+	TileSpawn * spawns = ALLOC_ARRAY(TileSpawn, MAX(map.spawn_count, 1));
+
+	u32 spawn_index = 0;
+	for(u32 x = 0; x < width; x++) {
+		column_offsets[x] = spawn_index;
+
+		for(u32 y = 0; y < TILE_MAP_HEIGHT; y++) {
+			u8 const * pixel = img_data + (y * width + x) * channels;
+
+			TileId id = get_tile_id_from_color(color_rgb8(pixel[0], pixel[1], pixel[2]));
+			if(id != TileId_null) {
+				TileSpawn * spawn = spawns + spawn_index++;
+				spawn->row = (u8)y;
+				spawn->id = (u8)id;
+			}
+		}
+	}
+
+	column_offsets[width] = spawn_index;
+	ASSERT(spawn_index == map.spawn_count);
+
+	map.column_offsets = column_offsets;
+	map.spawns = spawns;
+
+	return map;
+}
+
 #define FONT_FIRST_CHAR '!'
 #define FONT_ONE_PAST_LAST_CHAR ('~' + 1)
 #define FONT_GLYPH_COUNT (FONT_ONE_PAST_LAST_CHAR - FONT_FIRST_CHAR)
+//NOTE: Distance in glyph pixels either side of the edge that the SDF atlas can represent!!
+#define FONT_SDF_SPREAD_PIXELS 4
 
 inline u32 get_font_glyph_index(char char_) {
 	u32 index = (u32)char_ - FONT_FIRST_CHAR;
@@ -99,7 +205,7 @@ struct FontGlyph {
 };
 
 struct Font {
-	FontGlyph * glyphs;
+	FontGlyph const * glyphs;
 	u32 glyph_id;
 
 	f32 ascent;
@@ -108,6 +214,8 @@ struct Font {
 
 	//TODO: Do we really need this??
 	u32 atlas_index;
+	//NOTE: Glyph sprites are shared by every size of a typeface, this takes them to the font's pixel height!!
+	f32 glyph_scale;
 };
 #pragma pack(pop)
 
@@ -289,7 +397,17 @@ enum AssetType {
 	AssetType_count,
 };
 
+//NOTE: Paks are deflated in independent blocks of this size so they can be inflated in parallel!!
+#define ASSET_PACK_BLOCK_SIZE KILOBYTES(256)
+
 #pragma pack(push, 1)
+//NOTE: Followed by block_count compressed sizes and then the raw deflate blocks!!
+struct CompressedAssetPackHeader {
+	u32 size;
+	u32 block_size;
+	u32 block_count;
+};
+
 struct AssetPackHeader {
 	u32 asset_count;
 };
@@ -300,6 +418,12 @@ struct TextureInfo {
 	math::Vec2 offset;
 
 	TextureSampling sampling;
+	TextureFormat format;
+	u32 mip_levels;
+
+	//NOTE: Set when the pixels are identical to an earlier texture in the pak, no pixel data follows!!
+	AssetId alias_id;
+	u32 alias_index;
 };
 
 struct SpriteInfo {
@@ -309,15 +433,21 @@ struct SpriteInfo {
 
 	u32 atlas_index;
 	math::Vec2 tex_coords[2];
+	//NOTE: Stored 90 degrees clockwise in the atlas!!
+	b32 rotated;
+	//NOTE: Convex outline in 0-1 sprite space (CCW), the vertices follow the info in the pak, 0 means a full quad!!
+	u32 mesh_vert_count;
 };
 
 struct AudioClipInfo {
 	u32 samples;
+	u32 channels;
 	u32 size;
 };
 
 struct TileMapInfo {
 	u32 width;
+	u32 spawn_count;
 };
 
 struct FontInfo {
@@ -328,6 +458,7 @@ struct FontInfo {
 	f32 whitespace_advance;
 
 	u32 atlas_index;
+	f32 glyph_scale;
 };
 
 struct AssetInfo {
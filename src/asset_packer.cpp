@@ -1,6 +1,7 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -8,11 +9,147 @@
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb_truetype.h>
 
+#define MINIZ_NO_TIME
+#define MINIZ_NO_ARCHIVE_APIS
+#include <miniz.c>
+
 #include <sys.hpp>
 
 #include <asset_format.hpp>
 
+#ifndef WIN32
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/stat.h>
+#endif
+
+//NOTE: Define PACK_NO_SIMD to force the scalar pixel kernels!!
+#if !defined(PACK_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PACK_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if PACK_SSE2 && defined(__AVX2__)
+#define PACK_AVX2 1
+#include <immintrin.h>
+#endif
+
+//NOTE: Build with PACK_SELF_TEST=1 to check every SIMD kernel against its scalar version on the pngs in dat and time both, nothing gets packed!!
+#ifndef PACK_SELF_TEST
+#define PACK_SELF_TEST 0
+#endif
+
 #define PACK_AUDIO_ASSETS 0
+#define PACK_MAX_THREADS 32
+#define PACK_MAX_ATLAS_SIZE 4096
+#define PACK_COMPRESSION_LEVEL MZ_BEST_COMPRESSION
+#define PACK_OUTPUT_DIR "pak"
+//NOTE: Relative to dat, embedded paks are compiled into the game as headers!!
+#define PACK_EMBED_DIR "../src"
+
+//NOTE: Delete the cache directory to force a full rebuild, bump the version whenever the packer's output changes!!
+#define PACK_CACHE_DIR "pack_cache"
+#define PACK_CACHE_VERSION 4
+
+#define FNV1A_SEED 14695981039346656037ull
+
+//NOTE: Glyph sets are built at this size, fonts at other sizes scale the sprites!!
+#define FONT_SDF_PIXEL_HEIGHT 32.0f
+#define FONT_SDF_UPSAMPLE 4
+#define FONT_SDF_INF 1e20f
+
+#ifdef WIN32
+typedef HANDLE PackThread;
+
+u32 atomic_fetch_add_u32(u32 volatile * value, u32 addend) {
+	return (u32)InterlockedExchangeAdd((LONG volatile *)value, (LONG)addend);
+}
+
+u32 get_processor_count() {
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+	return MAX((u32)system_info.dwNumberOfProcessors, 1);
+}
+
+void make_directory(char const * path) {
+	CreateDirectoryA(path, 0);
+}
+
+f64 get_time_ms() {
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (f64)counter.QuadPart * 1000.0 / (f64)frequency.QuadPart;
+}
+
+//NOTE: Files in the working directory matching the pattern, returns how many names were written!!
+u32 find_files(char const * pattern, char (* names)[256], u32 max_count) {
+	u32 count = 0;
+
+	WIN32_FIND_DATAA find_data;
+	HANDLE find = FindFirstFileA(pattern, &find_data);
+	if(find != INVALID_HANDLE_VALUE) {
+		do {
+			if(count < max_count && !(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+				std::snprintf(names[count++], 256, "%s", find_data.cFileName);
+			}
+		}
+		while(FindNextFileA(find, &find_data));
+
+		FindClose(find);
+	}
+
+	return count;
+}
+#else
+typedef pthread_t PackThread;
+
+u32 atomic_fetch_add_u32(u32 volatile * value, u32 addend) {
+	return __sync_fetch_and_add(value, addend);
+}
+
+u32 get_processor_count() {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+}
+
+void make_directory(char const * path) {
+	mkdir(path, 0777);
+}
+
+f64 get_time_ms() {
+	timespec time_;
+	clock_gettime(CLOCK_MONOTONIC, &time_);
+	return (f64)time_.tv_sec * 1000.0 + (f64)time_.tv_nsec / 1000000.0;
+}
+
+//NOTE: Only "*.ext" patterns, that's all the packer needs!!
+u32 find_files(char const * pattern, char (* names)[256], u32 max_count) {
+	ASSERT(pattern[0] == '*');
+	char const * ext = pattern + 1;
+	size_t ext_len = std::strlen(ext);
+
+	u32 count = 0;
+
+	DIR * dir = opendir(".");
+	if(dir) {
+		dirent * entry = 0;
+		while((entry = readdir(dir)) && count < max_count) {
+			size_t len = std::strlen(entry->d_name);
+			if(len > ext_len && std::strcmp(entry->d_name + len - ext_len, ext) == 0) {
+				std::snprintf(names[count++], 256, "%s", entry->d_name);
+			}
+		}
+
+		closedir(dir);
+	}
+
+	return count;
+}
+#endif
 
 #define PACK_RIFF_CODE(x, y, z, w) ((u32)(x) << 0) | ((u32)(y) << 8) | ((u32)(z) << 16) | ((u32)(w) << 24)
 enum RiffCode {
@@ -54,24 +191,53 @@ struct Texture {
 	u32 width;
 	u32 height;
 	TextureSampling sampling;
+	TextureFormat format;
+	u32 mip_levels;
 
 	u32 size;
 	u8 * ptr;
 
+	u64 hash;
+	u32 alias_of;
+};
+
+struct PackRect {
 	u32 x;
 	u32 y;
-	u32 safe_y;
+	u32 width;
+	u32 height;
+};
+
+struct MaxRectsBin {
+	u32 width;
+	u32 height;
+
+	u32 free_count;
+	u32 free_max;
+	PackRect * free_rects;
 };
 
-struct TexCoord {
-	u32 u;
-	u32 v;
+//NOTE: Trimmed pixels waiting for the atlas to be laid out!!
+struct AtlasRect {
+	Texture tex;
+
+	u32 cell_width;
+	u32 cell_height;
+
+	PackRect cell;
+	b32 rotated;
+
+	u32 mesh_vert_count;
+	math::Vec2 mesh_verts[SPRITE_MAX_MESH_VERTS];
+	f32 quad_area;
+	f32 mesh_area;
 };
 
 struct AudioClip {
 	AssetId id;
 
 	u32 samples;
+	u32 channels;
 
 	u32 size;
 	i16 * ptr;
@@ -79,10 +245,17 @@ struct AudioClip {
 
 struct TextureAtlas {
 	Texture tex;
+	TextureSampling sampling;
+	b32 mipped;
+	b32 allow_rotation;
 
 	//TODO: These can just be part of the texture struct and we'll alloc them!!
 	u32 sprite_count;
-	AssetInfo sprites[256];
+	AssetInfo sprites[512];
+	u32 sprite_rects[512];
+
+	u32 rect_count;
+	AtlasRect rects[512];
 };
 
 struct TileMapAsset {
@@ -100,9 +273,76 @@ struct AssetFile {
 	AssetId id;
 };
 
+struct FontGlyphBitmap {
+	Texture tex;
+	i32 x_offset;
+	i32 y_offset;
+};
+
+enum PackJobType {
+	PackJobType_texture,
+	PackJobType_sprite,
+	PackJobType_sprite_sheet,
+	PackJobType_font,
+	PackJobType_audio_clip,
+	PackJobType_tile_map,
+};
+
+struct PackJob {
+	PackJobType type;
+	char file_name[256];
+	AssetId id;
+
+	//NOTE: Atlas index for sprites, otherwise the packer slot the job fills in!!
+	u32 index;
+	TextureSampling sampling;
+
+	u32 sprite_width;
+	u32 sprite_height;
+	u32 max_sprites;
+
+	f32 pixel_height;
+	b32 rasterize_glyphs;
+
+	Texture tex;
+	FontGlyphBitmap * glyph_bitmaps;
+
+	//NOTE: Hash of the input file and every parameter run_pack_job uses, names the cached result!!
+	u64 key;
+};
+
+typedef void ParallelProc(void * data, u32 index);
+
+struct ParallelWork {
+	ParallelProc * proc;
+	void * data;
+	u32 count;
+	u32 volatile next_index;
+};
+
+struct PackBlock {
+	u8 * src;
+	u32 src_size;
+
+	u8 * dst;
+	size_t dst_size;
+};
+
+struct PackCacheHeader {
+	u32 version;
+	u32 type;
+	u64 key;
+};
+
+struct PackCacheReader {
+	MemoryPtr file;
+	size_t pos;
+};
+
 struct AssetPacker {
 	u32 atlas_count;
 	TextureAtlas atlases[32];
+	u32 font_atlas_index;
 
 	u32 font_count;
 	FontAsset fonts[256];
@@ -115,11 +355,237 @@ struct AssetPacker {
 
 	u32 tile_map_count;
 	TileMapAsset tile_maps[256];
+
+	u32 job_count;
+	PackJob jobs[512];
+	u32 volatile cache_hit_count;
 };
 
-u8 * load_image_from_file(char const * file_name, i32 * width, i32 * height, i32 * channels) {
-	stbi_set_flip_vertically_on_load(true);
+//NOTE: Pixel kernels, all RGBA8 unless stated otherwise. SIMD paths must match the scalar ones bit for bit!!
+
+inline u8 mul_div_255(u32 x, u32 y) {
+	//NOTE: Exactly round(x * y / 255) for x, y in [0, 255]!!
+	u32 t = x * y + 128;
+	return (u8)((t + (t >> 8)) >> 8);
+}
+
+void premultiply_alpha_scalar(u8 * ptr, u32 pixel_count) {
+	for(u32 i = 0; i < pixel_count; i++, ptr += 4) {
+		u32 a = ptr[3];
+		ptr[0] = mul_div_255(ptr[0], a);
+		ptr[1] = mul_div_255(ptr[1], a);
+		ptr[2] = mul_div_255(ptr[2], a);
+	}
+}
+
+#if PACK_SSE2
+inline __m128i premultiply_alpha_sse2_u16(__m128i c, __m128i rgb_mask, __m128i alpha_255) {
+	//NOTE: 2 pixels as u16, broadcast each pixel's alpha and swap it for 255 in the alpha lane so alpha comes out unchanged!!
+	__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	a = _mm_or_si128(_mm_and_si128(a, rgb_mask), alpha_255);
+
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+#endif
+
+#if PACK_AVX2
+inline __m256i premultiply_alpha_avx2_u16(__m256i c, __m256i rgb_mask, __m256i alpha_255) {
+	__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	a = _mm256_or_si256(_mm256_and_si256(a, rgb_mask), alpha_255);
+
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(c, a), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+#endif
+
+void premultiply_alpha(u8 * ptr, u32 pixel_count) {
+	u32 i = 0;
+
+#if PACK_AVX2
+	{
+		__m256i zero = _mm256_setzero_si256();
+		__m256i rgb_mask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+		__m256i alpha_255 = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+
+		for(; i + 8 <= pixel_count; i += 8) {
+			__m256i * p = (__m256i *)(ptr + i * 4);
+			__m256i c = _mm256_loadu_si256(p);
+
+			__m256i lo = premultiply_alpha_avx2_u16(_mm256_unpacklo_epi8(c, zero), rgb_mask, alpha_255);
+			__m256i hi = premultiply_alpha_avx2_u16(_mm256_unpackhi_epi8(c, zero), rgb_mask, alpha_255);
+
+			//NOTE: Unpack and pack both work per 128 bit lane so the pixel order comes back unchanged!!
+			_mm256_storeu_si256(p, _mm256_packus_epi16(lo, hi));
+		}
+	}
+#endif
+
+#if PACK_SSE2
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+		__m128i alpha_255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+		for(; i + 4 <= pixel_count; i += 4) {
+			__m128i * p = (__m128i *)(ptr + i * 4);
+			__m128i c = _mm_loadu_si128(p);
+
+			__m128i lo = premultiply_alpha_sse2_u16(_mm_unpacklo_epi8(c, zero), rgb_mask, alpha_255);
+			__m128i hi = premultiply_alpha_sse2_u16(_mm_unpackhi_epi8(c, zero), rgb_mask, alpha_255);
+
+			_mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+		}
+	}
+#endif
+
+	premultiply_alpha_scalar(ptr + i * 4, pixel_count - i);
+}
+
+void expand_rgb_to_rgba_scalar(u8 * dst, u8 * src, u32 pixel_count) {
+	for(u32 i = 0; i < pixel_count; i++, dst += 4, src += 3) {
+		dst[0] = src[0];
+		dst[1] = src[1];
+		dst[2] = src[2];
+		dst[3] = 255;
+	}
+}
+
+void expand_rgb_to_rgba(u8 * dst, u8 * src, u32 pixel_count) {
+	u32 i = 0;
+
+#if PACK_AVX2
+	{
+		//NOTE: Reads 16 bytes for every 12 used, so stop while there's a whole extra pixel of source left!!
+		__m128i shuffle = _mm_set_epi8(-1, 11, 10, 9, -1, 8, 7, 6, -1, 5, 4, 3, -1, 2, 1, 0);
+		__m128i alpha = _mm_set1_epi32((i32)0xFF000000);
+
+		for(; i + 6 <= pixel_count; i += 4) {
+			__m128i c = _mm_loadu_si128((__m128i *)(src + i * 3));
+			_mm_storeu_si128((__m128i *)(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(c, shuffle), alpha));
+		}
+	}
+#elif PACK_SSE2
+	{
+		//NOTE: No byte shuffle, so shift each pixel down to the bottom lane and interleave the bottom lanes back together!!
+		__m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+		__m128i alpha = _mm_set1_epi32((i32)0xFF000000);
+
+		for(; i + 6 <= pixel_count; i += 4) {
+			__m128i c = _mm_loadu_si128((__m128i *)(src + i * 3));
+
+			__m128i p01 = _mm_unpacklo_epi32(c, _mm_srli_si128(c, 3));
+			__m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(c, 6), _mm_srli_si128(c, 9));
+			__m128i p = _mm_unpacklo_epi64(p01, p23);
+
+			_mm_storeu_si128((__m128i *)(dst + i * 4), _mm_or_si128(_mm_and_si128(p, rgb_mask), alpha));
+		}
+	}
+#endif
+
+	expand_rgb_to_rgba_scalar(dst + i * 4, src + i * 3, pixel_count - i);
+}
+
+struct PixelBounds {
+	u32 min_x;
+	u32 min_y;
+	u32 max_x;
+	u32 max_y;
+};
+
+void include_alpha_row(PixelBounds * bounds, u8 * row, u32 y, u32 width, u32 row_min_x) {
+	u32 row_max_x = row_min_x;
+	for(u32 xx = width; xx > row_min_x; xx--) {
+		if(row[(xx - 1) * 4 + 3]) {
+			row_max_x = xx - 1;
+			break;
+		}
+	}
+
+	bounds->min_x = MIN(bounds->min_x, row_min_x);
+	bounds->max_x = MAX(bounds->max_x, row_max_x);
+	bounds->min_y = MIN(bounds->min_y, y);
+	bounds->max_y = y;
+}
+
+PixelBounds find_alpha_bounds_scalar(u8 * ptr, u32 width, u32 height) {
+	PixelBounds bounds = {};
+	bounds.min_x = U32_MAX;
+	bounds.min_y = U32_MAX;
+
+	for(u32 y = 0; y < height; y++) {
+		u8 * row = ptr + y * width * 4;
+
+		for(u32 x = 0; x < width; x++) {
+			if(row[x * 4 + 3]) {
+				include_alpha_row(&bounds, row, y, width, x);
+				break;
+			}
+		}
+	}
+
+	return bounds;
+}
+
+//NOTE: Bounds of the pixels with non-zero alpha, min > max if there are none!!
+PixelBounds find_alpha_bounds(u8 * ptr, u32 width, u32 height) {
+	PixelBounds bounds = {};
+	bounds.min_x = U32_MAX;
+	bounds.min_y = U32_MAX;
+
+	for(u32 y = 0; y < height; y++) {
+		u8 * row = ptr + y * width * 4;
+
+		u32 row_min_x = U32_MAX;
+		u32 x = 0;
+
+#if PACK_SSE2
+		{
+			__m128i zero = _mm_setzero_si128();
+			for(; x + 4 <= width; x += 4) {
+				//NOTE: Only the alpha bytes (3, 7, 11, 15) matter!!
+				u32 empty = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)(row + x * 4)), zero));
+				if((empty & 0x8888) != 0x8888) {
+					break;
+				}
+			}
+		}
+#endif
+
+		for(; x < width; x++) {
+			if(row[x * 4 + 3]) {
+				row_min_x = x;
+				break;
+			}
+		}
+
+		if(row_min_x != U32_MAX) {
+			include_alpha_row(&bounds, row, y, width, row_min_x);
+		}
+	}
+
+	return bounds;
+}
+
+void copy_pixel_rect_scalar(u8 * dst, u32 dst_width, u32 dst_x, u32 dst_y, u8 * src, u32 src_width, u32 src_x, u32 src_y, u32 width, u32 height) {
+	for(u32 y = 0; y < height; y++) {
+		u8 * d = dst + ((dst_y + y) * dst_width + dst_x) * 4;
+		u8 * s = src + ((src_y + y) * src_width + src_x) * 4;
+		for(u32 i = 0; i < width * 4; i++) {
+			d[i] = s[i];
+		}
+	}
+}
 
+void copy_pixel_rect(u8 * dst, u32 dst_width, u32 dst_x, u32 dst_y, u8 * src, u32 src_width, u32 src_x, u32 src_y, u32 width, u32 height) {
+	for(u32 y = 0; y < height; y++) {
+		u8 * d = dst + ((dst_y + y) * dst_width + dst_x) * 4;
+		u8 * s = src + ((src_y + y) * src_width + src_x) * 4;
+		std::memcpy(d, s, width * 4);
+	}
+}
+
+u8 * load_image_from_file(char const * file_name, i32 * width, i32 * height, i32 * channels) {
 	u8 * img_data = stbi_load(file_name, width, height, channels, 0);
 	if(!img_data) {
 		std::printf("ERROR: Could not find %s!!\n", file_name);
@@ -137,28 +603,9 @@ TileMapAsset load_tile_map(char const * file_name, AssetId asset_id) {
 
 	TileMapAsset map_asset = {};
 	map_asset.id = asset_id;
-	map_asset.map.width = (u32)width;
-	map_asset.map.tiles = ALLOC_ARRAY(Tiles, width);
-
-	for(u32 x = 0; x < (u32)width; x++) {
-		Tiles * tiles = map_asset.map.tiles + x;
-
-		for(u32 y = 0; y < TILE_MAP_HEIGHT; y++) {
-			u32 i = (y * (u32)width + x) * channels;
-			ColorRGB8 color = color_rgb8(img_data[i + 0], img_data[i + 1], img_data[i + 2]);
-
-			TileId id = TileId_null;
-			for(u32 ii = 0; ii < ARRAY_COUNT(tile_id_color_table); ii++) {
-				TileIdColorRGB8 id_color = tile_id_color_table[ii];
-				if(colors_are_equal(color, id_color.color)) {
-					id = id_color.id;
-					break;
-				}
-			}
+	map_asset.map = create_tile_map(img_data, (u32)width, (u32)channels);
 
-			tiles->ids[y] = id;
-		}
-	}
+	stbi_image_free(img_data);
 
 	return map_asset;
 }
@@ -175,43 +622,19 @@ Texture load_texture(char const * file_name, AssetId id, TextureSampling samplin
 
 	if(channels == 4) {
 		//NOTE: Premultiplied alpha!!
-		f32 r_255 = 1.0f / 255.0f;
-		for(u32 y = 0, i = 0; y < tex.height; y++) {
-			for(u32 x = 0; x < tex.width; x++, i += 4) {
-				f32 a = (f32)img_data[i + 3] * r_255;
-
-				f32 r = (f32)img_data[i + 0] * r_255 * a;
-				f32 g = (f32)img_data[i + 1] * r_255 * a;
-				f32 b = (f32)img_data[i + 2] * r_255 * a;
-
-				img_data[i + 0] = (u8)(r * 255.0f);
-				img_data[i + 1] = (u8)(g * 255.0f);
-				img_data[i + 2] = (u8)(b * 255.0f);
-			}
-		}
+		premultiply_alpha(img_data, tex.width * tex.height);
 	}
 	else {
 		ASSERT(channels == 3);
 
-		u8 * img_data_ = ALLOC_MEMORY(u8, tex.width * tex.height * TEXTURE_CHANNELS);
-
-		for(u32 y = 0, i = 0; y < tex.height; y++) {
-			for(u32 x = 0; x < tex.width; x++, i++) {
-				u32 i3 = i * 3;
-				u32 i4 = i * 4;
-
-				img_data_[i4 + 0] = img_data[i3 + 0];
-				img_data_[i4 + 1] = img_data[i3 + 1];
-				img_data_[i4 + 2] = img_data[i3 + 2];
-				img_data_[i4 + 3] = 255;
-			}
-		}
+		u8 * img_data_ = ALLOC_MEMORY(u8, tex.width * tex.height * TEXTURE_CHANNELS, false);
+		expand_rgb_to_rgba(img_data_, img_data, tex.width * tex.height);
 
 		stbi_image_free(img_data);
 		img_data = img_data_;
 	}
 
-
+	tex.mip_levels = 1;
 	tex.size = tex.width * tex.height * TEXTURE_CHANNELS;
 	tex.ptr = img_data;
 
@@ -225,13 +648,11 @@ Texture allocate_texture(u32 width, u32 height, AssetId id, TextureSampling samp
 	tex.width = width;
 	tex.height = height;
 	tex.sampling = sampling;
+	tex.mip_levels = 1;
 
 	tex.size = tex.width * tex.height * TEXTURE_CHANNELS;
 	tex.ptr = ALLOC_ARRAY(u8, tex.size);
 
-	tex.x = TEXTURE_PADDING_PIXELS;
-	tex.y = tex.safe_y = TEXTURE_PADDING_PIXELS;
-
 	for(u32 y = 0, i = 0; y < tex.height; y++) {
 		for(u32 x = 0; x < tex.width; x++, i += 4) {
 			tex.ptr[i + 0] = 0;
@@ -244,86 +665,115 @@ Texture allocate_texture(u32 width, u32 height, AssetId id, TextureSampling samp
 	return tex;
 }
 
-struct Blit { u32 u; u32 v; u32 width; u32 height; i32 min_x; i32 min_y; };
-Blit blit_texture(Texture * dst, Texture * src) {
-	u32 min_x = U32_MAX;
-	u32 min_y = U32_MAX;
-
-	u32 max_x = 0;
-	u32 max_y = 0;
+b32 texture_is_opaque(Texture * tex) {
+	b32 opaque = true;
+	for(u32 i = 0; i < tex->size; i += TEXTURE_CHANNELS) {
+		if(tex->ptr[i + 3] != 255) {
+			opaque = false;
+			break;
+		}
+	}
 
-	for(u32 y = 0, i = 0; y < src->height; y++) {
-		for(u32 x = 0; x < src->width; x++, i += 4) {
-			u8 a = src->ptr[i + 3];
-			if(a) {
-				if(x < min_x) {
-					min_x = x;
-				}
+	return opaque;
+}
 
-				if(y < min_y) {
-					min_y = y;
-				}
+void write_texture_level(u8 * ptr, u32 width, u32 height, TextureFormat format, std::FILE * file_ptr) {
+	if(format == TextureFormat_rgba8) {
+		std::fwrite(ptr, width * height * TEXTURE_CHANNELS, 1, file_ptr);
+	}
+	else {
+		u32 pixel_count = width * height;
+		u8 * data = ALLOC_ARRAY(u8, pixel_count * get_texture_format_bytes_per_pixel(format));
 
-				if(x > max_x) {
-					max_x = x;
-				}
+		for(u32 i = 0; i < pixel_count; i++) {
+			u8 * pixel = ptr + i * TEXTURE_CHANNELS;
 
-				if(y > max_y) {
-					max_y = y;
-				}
+			if(format == TextureFormat_rgb565) {
+				u32 r = (pixel[0] * 31 + 127) / 255;
+				u32 g = (pixel[1] * 63 + 127) / 255;
+				u32 b = (pixel[2] * 31 + 127) / 255;
+				((u16 *)data)[i] = (u16)((r << 11) | (g << 5) | b);
+			}
+			else {
+				ASSERT(format == TextureFormat_luminance_alpha);
+				data[i * 2 + 0] = pixel[0];
+				data[i * 2 + 1] = pixel[3];
 			}
 		}
-	}
-
-	u32 width = (max_x + 1) - min_x;
-	u32 height = (max_y + 1) - min_y;
-	ASSERT(width > 0 && height > 0);
 
-	u32 pad = TEXTURE_PADDING_PIXELS;
-	u32 pad_2 = pad * 2;
+		std::fwrite(data, pixel_count * get_texture_format_bytes_per_pixel(format), 1, file_ptr);
+		FREE_MEMORY(data);
+	}
+}
 
-	ASSERT((width + pad_2) <= dst->width);
+void write_texture_data(Texture * tex, std::FILE * file_ptr) {
+	//NOTE: Textures are built as RGBA8 and only narrowed to their final format on the way out!!
+	write_texture_level(tex->ptr, tex->width, tex->height, tex->format, file_ptr);
+
+	if(tex->mip_levels > 1) {
+		u8 * src = tex->ptr;
+		u32 src_width = tex->width;
+		u32 src_height = tex->height;
+
+		for(u32 level = 1; level < tex->mip_levels; level++) {
+			u32 width = get_texture_mip_dim(tex->width, level);
+			u32 height = get_texture_mip_dim(tex->height, level);
+			u8 * dst = ALLOC_ARRAY(u8, width * height * TEXTURE_CHANNELS);
+
+			//NOTE: 2x2 box filter, colors are already premultiplied so they can be averaged directly!!
+			for(u32 y = 0; y < height; y++) {
+				for(u32 x = 0; x < width; x++) {
+					u32 x0 = MIN(x * 2, src_width - 1);
+					u32 x1 = MIN(x * 2 + 1, src_width - 1);
+					u32 y0 = MIN(y * 2, src_height - 1);
+					u32 y1 = MIN(y * 2 + 1, src_height - 1);
+
+					u8 * p00 = src + (y0 * src_width + x0) * TEXTURE_CHANNELS;
+					u8 * p10 = src + (y0 * src_width + x1) * TEXTURE_CHANNELS;
+					u8 * p01 = src + (y1 * src_width + x0) * TEXTURE_CHANNELS;
+					u8 * p11 = src + (y1 * src_width + x1) * TEXTURE_CHANNELS;
+
+					u8 * pixel = dst + (y * width + x) * TEXTURE_CHANNELS;
+					for(u32 i = 0; i < TEXTURE_CHANNELS; i++) {
+						pixel[i] = (u8)((p00[i] + p10[i] + p01[i] + p11[i] + 2) / 4);
+					}
+				}
+			}
 
-	if((dst->x + width + pad) > dst->width) {
-		dst->x = pad;
-		dst->y = dst->safe_y;
-	}
+			write_texture_level(dst, width, height, tex->format, file_ptr);
 
-	ASSERT((dst->y + height + pad) <= dst->height);
+			if(src != tex->ptr) {
+				FREE_MEMORY(src);
+			}
 
-	for(u32 y = 0; y < height; y++) {
-		for(u32 x = 0; x < width; x++) {
-			u32 d_i = ((y + dst->y) * dst->width + x + dst->x) * TEXTURE_CHANNELS;
-			u32 s_i = ((y + min_y) * src->width + (x + min_x)) * TEXTURE_CHANNELS;
+			src = dst;
+			src_width = width;
+			src_height = height;
+		}
 
-			dst->ptr[d_i + 0] = src->ptr[s_i + 0];
-			dst->ptr[d_i + 1] = src->ptr[s_i + 1];
-			dst->ptr[d_i + 2] = src->ptr[s_i + 2];
-			dst->ptr[d_i + 3] = src->ptr[s_i + 3];
+		if(src != tex->ptr) {
+			FREE_MEMORY(src);
 		}
 	}
+}
 
-	Blit result = {};
-	result.u = dst->x - pad;
-	result.v = dst->y - pad;
-	result.width = width + pad_2;
-	result.height = height + pad_2;
-	result.min_x = (i32)min_x - 1;
-	result.min_y = (i32)min_y - 1;
-
-	u32 y = dst->y + height + pad_2;
-	if(y > dst->safe_y) {
-		dst->safe_y = y;
+u64 fnv1a_hash(u64 hash, void const * ptr, size_t size) {
+	u8 const * bytes = (u8 const *)ptr;
+	for(size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
 	}
 
-	dst->x += width + pad_2;
-	ASSERT(dst->x <= (dst->width + pad));
-	if(dst->x >= dst->width) {
-		dst->x = pad;
-		dst->y = dst->safe_y;
-	}
+	return hash;
+}
+
+u64 hash_texture(Texture * tex) {
+	u32 header[2] = { tex->width, tex->height };
+	u64 hash = fnv1a_hash(FNV1A_SEED, header, sizeof(header));
+	return fnv1a_hash(hash, tex->ptr, tex->size);
+}
 
-	return result;
+b32 textures_are_equal(Texture * tex0, Texture * tex1) {
+	return tex0->width == tex1->width && tex0->height == tex1->height && tex0->size == tex1->size && std::memcmp(tex0->ptr, tex1->ptr, tex0->size) == 0;
 }
 
 AudioClip load_audio_clip(char const * file_name, AssetId id) {
@@ -353,23 +803,15 @@ AudioClip load_audio_clip(char const * file_name, AssetId id) {
 
 	i16 * wav_data = (i16 *)((u8 *)wav_data_header + sizeof(WavChunkHeader));
 
-	clip.samples = wav_data_header->size / (wav_format->channels * sizeof(i16));
+	clip.channels = wav_format->channels;
+	clip.samples = wav_data_header->size / (clip.channels * sizeof(i16));
 	ASSERT(clip.samples > 0);
 	u32 samples_with_padding = clip.samples + AUDIO_PADDING_SAMPLES;
 
-	clip.size = samples_with_padding * sizeof(i16) * AUDIO_CHANNELS;
+	clip.size = samples_with_padding * sizeof(i16) * clip.channels;
 	clip.ptr = ALLOC_MEMORY(i16, clip.size);
-	if(wav_format->channels == 2) {
-		for(u32 i = 0; i < samples_with_padding * 2; i++) {
-			clip.ptr[i] = wav_data[i % (clip.samples * 2)];
-		}
-	}
-	else {
-		for(u32 i = 0, sample_index = 0; i < samples_with_padding; i++) {
-			i16 sample = wav_data[i % clip.samples];
-			clip.ptr[sample_index++] = sample;
-			clip.ptr[sample_index++] = sample;
-		}
+	for(u32 i = 0; i < samples_with_padding * clip.channels; i++) {
+		clip.ptr[i] = wav_data[i % (clip.samples * clip.channels)];
 	}
 
 	FREE_MEMORY(file_buffer.ptr);
@@ -377,133 +819,1338 @@ AudioClip load_audio_clip(char const * file_name, AssetId id) {
 	return clip;
 }
 
-void push_sprite(TextureAtlas * atlas, AssetId asset_id, u32 atlas_index, Blit * blit, math::Vec2 sprite_dim) {
-	ASSERT(atlas->sprite_count < ARRAY_COUNT(atlas->sprites));
-	AssetInfo * info = atlas->sprites + atlas->sprite_count++;
-	info->id = asset_id;
-	info->type = AssetType_sprite;
+b32 rects_intersect(PackRect * rect0, PackRect * rect1) {
+	return rect0->x < (rect1->x + rect1->width) && rect1->x < (rect0->x + rect0->width) && rect0->y < (rect1->y + rect1->height) && rect1->y < (rect0->y + rect0->height);
+}
 
-	math::Vec2 r_atlas_dim = math::vec2(1.0f / (f32)atlas->tex.width, 1.0f / (f32)atlas->tex.height);
-	math::Rec2 blit_rec = math::rec2_min_dim(math::vec2(blit->min_x, blit->min_y), math::vec2(blit->width, blit->height));
+b32 rect_contains(PackRect * outer, PackRect * inner) {
+	return inner->x >= outer->x && inner->y >= outer->y && (inner->x + inner->width) <= (outer->x + outer->width) && (inner->y + inner->height) <= (outer->y + outer->height);
+}
 
-	SpriteInfo * sprite = &info->sprite;
-	sprite->atlas_index = atlas_index;
-	sprite->width = blit->width;
-	sprite->height = blit->height;
-	sprite->offset = math::rec_pos(blit_rec) - sprite_dim * 0.5f;
-	sprite->tex_coords[0] = math::vec2(blit->u, blit->v) * r_atlas_dim;
-	sprite->tex_coords[1] = math::vec2(blit->u + blit->width, blit->v + blit->height) * r_atlas_dim;
+void push_free_rect(MaxRectsBin * bin, u32 x, u32 y, u32 width, u32 height) {
+	if(bin->free_count == bin->free_max) {
+		u32 free_max = bin->free_max ? bin->free_max * 2 : 256;
+		PackRect * free_rects = ALLOC_ARRAY(PackRect, free_max, false);
+		if(bin->free_rects) {
+			std::memcpy(free_rects, bin->free_rects, sizeof(PackRect) * bin->free_count);
+			FREE_MEMORY(bin->free_rects);
+		}
+
+		bin->free_rects = free_rects;
+		bin->free_max = free_max;
+	}
+
+	PackRect * rect = bin->free_rects + bin->free_count++;
+	rect->x = x;
+	rect->y = y;
+	rect->width = width;
+	rect->height = height;
 }
 
-void push_font(AssetPacker * packer, char const * file_name, AssetId font_id, f32 pixel_height) {
-	ASSERT(packer->atlas_count < ARRAY_COUNT(packer->atlases));
-	ASSERT(packer->font_count < ARRAY_COUNT(packer->fonts));
+void begin_max_rects_bin(MaxRectsBin * bin, u32 width, u32 height) {
+	bin->width = width;
+	bin->height = height;
+	bin->free_count = 0;
+	push_free_rect(bin, 0, 0, width, height);
+}
 
-	FontAsset * font_asset = packer->fonts + packer->font_count++;
-	font_asset->id = font_id;
+//NOTE: MaxRects with the best short side fit heuristic!!
+b32 max_rects_insert(MaxRectsBin * bin, u32 width, u32 height, b32 allow_rotation, PackRect * result, b32 * rotated) {
+	u32 best_short_side = U32_MAX;
+	u32 best_long_side = U32_MAX;
 
-	stbtt_fontinfo ttf_info;
-	MemoryPtr ttf_file = read_file_to_memory(file_name);
-	ASSERT(ttf_file.ptr);
-	stbtt_InitFont(&ttf_info, ttf_file.ptr, stbtt_GetFontOffsetForIndex(ttf_file.ptr, 0));
+	for(u32 i = 0; i < bin->free_count; i++) {
+		PackRect * free_rect = bin->free_rects + i;
 
-	f32 scale_factor = stbtt_ScaleForPixelHeight(&ttf_info, pixel_height);
+		for(u32 r = 0; r < (allow_rotation ? 2u : 1u); r++) {
+			u32 w = r ? height : width;
+			u32 h = r ? width : height;
 
-	i32 ascent, descent, line_gap;
-	stbtt_GetFontVMetrics(&ttf_info, &ascent, &descent, &line_gap);
-	// std::printf("LOG: %f\n", line_gap * scale_factor);
+			if(w <= free_rect->width && h <= free_rect->height) {
+				u32 short_side = MIN(free_rect->width - w, free_rect->height - h);
+				u32 long_side = MAX(free_rect->width - w, free_rect->height - h);
 
-	i32 whitespace_advance;
-	stbtt_GetCodepointHMetrics(&ttf_info, ' ', &whitespace_advance, 0);
+				if(short_side < best_short_side || (short_side == best_short_side && long_side < best_long_side)) {
+					best_short_side = short_side;
+					best_long_side = long_side;
+
+					result->x = free_rect->x;
+					result->y = free_rect->y;
+					result->width = w;
+					result->height = h;
+					*rotated = r == 1;
+				}
+			}
+		}
+	}
+
+	b32 placed = best_short_side != U32_MAX;
+	if(placed) {
+		//NOTE: Split every free rect the new one overlaps into the (up to) 4 maximal rects around it!!
+		u32 free_count = bin->free_count;
+		for(u32 i = 0; i < free_count; i++) {
+			PackRect free_rect = bin->free_rects[i];
+			if(rects_intersect(&free_rect, result)) {
+				if(result->x > free_rect.x) {
+					push_free_rect(bin, free_rect.x, free_rect.y, result->x - free_rect.x, free_rect.height);
+				}
+
+				if((result->x + result->width) < (free_rect.x + free_rect.width)) {
+					push_free_rect(bin, result->x + result->width, free_rect.y, (free_rect.x + free_rect.width) - (result->x + result->width), free_rect.height);
+				}
+
+				if(result->y > free_rect.y) {
+					push_free_rect(bin, free_rect.x, free_rect.y, free_rect.width, result->y - free_rect.y);
+				}
+
+				if((result->y + result->height) < (free_rect.y + free_rect.height)) {
+					push_free_rect(bin, free_rect.x, result->y + result->height, free_rect.width, (free_rect.y + free_rect.height) - (result->y + result->height));
+				}
+
+				bin->free_rects[i].width = 0;
+			}
+		}
+
+		//NOTE: Drop the split rects and any rect that is contained in another!!
+		for(u32 i = 0; i < bin->free_count; i++) {
+			PackRect * rect = bin->free_rects + i;
+			if(rect->width) {
+				for(u32 ii = 0; ii < bin->free_count; ii++) {
+					PackRect * other = bin->free_rects + ii;
+					if(ii != i && other->width && rect_contains(other, rect) && (!rect_contains(rect, other) || ii < i)) {
+						rect->width = 0;
+						break;
+					}
+				}
+			}
+		}
+
+		u32 write_index = 0;
+		for(u32 i = 0; i < bin->free_count; i++) {
+			if(bin->free_rects[i].width) {
+				bin->free_rects[write_index++] = bin->free_rects[i];
+			}
+		}
+
+		bin->free_count = write_index;
+	}
+
+	return placed;
+}
+
+inline f32 get_turn(math::Vec2 o, math::Vec2 a, math::Vec2 b) {
+	return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+f32 get_polygon_area(math::Vec2 * verts, u32 vert_count) {
+	f32 area = 0.0f;
+	for(u32 i = 0; i < vert_count; i++) {
+		math::Vec2 p0 = verts[i];
+		math::Vec2 p1 = verts[(i + 1) % vert_count];
+		area += p0.x * p1.y - p1.x * p0.y;
+	}
+
+	return area * 0.5f;
+}
+
+int compare_hull_points(void const * a, void const * b) {
+	math::Vec2 const * p0 = (math::Vec2 const *)a;
+	math::Vec2 const * p1 = (math::Vec2 const *)b;
+	if(p0->x != p1->x) {
+		return p0->x < p1->x ? -1 : 1;
+	}
+
+	return p0->y < p1->y ? -1 : (p0->y > p1->y ? 1 : 0);
+}
+
+//NOTE: Andrew's monotone chain, CCW with y up, points are sorted in place and the hull is written over the front of the array!!
+u32 build_convex_hull(math::Vec2 * points, u32 point_count, math::Vec2 * hull) {
+	std::qsort(points, point_count, sizeof(math::Vec2), compare_hull_points);
+
+	u32 count = 0;
+	for(u32 i = 0; i < point_count; i++) {
+		while(count >= 2 && get_turn(hull[count - 2], hull[count - 1], points[i]) <= 0.0f) {
+			count--;
+		}
+
+		hull[count++] = points[i];
+	}
+
+	u32 lower_count = count + 1;
+	for(u32 i = point_count - 1; i > 0; i--) {
+		while(count >= lower_count && get_turn(hull[count - 2], hull[count - 1], points[i - 1]) <= 0.0f) {
+			count--;
+		}
+
+		hull[count++] = points[i - 1];
+	}
+
+	//NOTE: Last point is the first one again!!
+	return count - 1;
+}
+
+//NOTE: Drops the edge that costs the least area by extending its neighbours until they meet, the result has to stay inside bounds!!
+b32 remove_cheapest_hull_edge(math::Vec2 * verts, u32 * vert_count, math::Rec2 bounds) {
+	u32 count = *vert_count;
+
+	u32 best_edge = U32_MAX;
+	f32 best_area = 0.0f;
+	math::Vec2 best_vert = math::vec2(0.0f);
+
+	for(u32 i = 0; i < count; i++) {
+		math::Vec2 p0 = verts[(i + count - 1) % count];
+		math::Vec2 p1 = verts[i];
+		math::Vec2 p2 = verts[(i + 1) % count];
+		math::Vec2 p3 = verts[(i + 2) % count];
+
+		math::Vec2 d0 = p1 - p0;
+		math::Vec2 d1 = p2 - p3;
+		f32 denom = d0.x * d1.y - d0.y * d1.x;
+		if(denom != 0.0f) {
+			math::Vec2 delta = p2 - p1;
+			f32 t = (delta.x * d1.y - delta.y * d1.x) / denom;
+			f32 u = (delta.x * d0.y - delta.y * d0.x) / denom;
+
+			if(t > 0.0f && u > 0.0f) {
+				math::Vec2 vert = p1 + d0 * t;
+
+				f32 epsilon = 1e-3f;
+				b32 inside = vert.x >= (bounds.min.x - epsilon) && vert.x <= (bounds.max.x + epsilon) && vert.y >= (bounds.min.y - epsilon) && vert.y <= (bounds.max.y + epsilon);
+
+				f32 area = get_turn(p1, vert, p2) * 0.5f;
+				if(inside && (best_edge == U32_MAX || area < best_area)) {
+					best_edge = i;
+					best_area = area;
+					best_vert = vert;
+				}
+			}
+		}
+	}
+
+	b32 removed = best_edge != U32_MAX;
+	if(removed) {
+		verts[best_edge] = best_vert;
+
+		u32 next = (best_edge + 1) % count;
+		for(u32 i = next; i < (count - 1); i++) {
+			verts[i] = verts[i + 1];
+		}
+
+		*vert_count = count - 1;
+	}
+
+	return removed;
+}
+
+//NOTE: Convex outline of the pixels with any alpha, grown by a pixel so bilinear filtering at the edges isn't clipped!!
+void build_sprite_mesh(AtlasRect * rect) {
+	Texture * tex = &rect->tex;
+	u32 width = tex->width;
+	u32 height = tex->height;
+
+	f32 pad = (f32)TEXTURE_PADDING_PIXELS;
+	math::Vec2 sprite_dim = math::vec2(width, height) + math::vec2(pad * 2.0f);
+	math::Rec2 bounds = math::rec2(math::vec2(-pad), math::vec2(width, height) + math::vec2(pad));
+
+	u32 point_count = 0;
+	math::Vec2 * points = ALLOC_ARRAY(math::Vec2, height * 4, false);
+	for(u32 y = 0; y < height; y++) {
+		u8 * row = tex->ptr + y * width * TEXTURE_CHANNELS;
+
+		u32 min_x = U32_MAX;
+		u32 max_x = 0;
+		for(u32 x = 0; x < width; x++) {
+			if(row[x * TEXTURE_CHANNELS + 3]) {
+				min_x = MIN(min_x, x);
+				max_x = x;
+			}
+		}
+
+		if(min_x != U32_MAX) {
+			f32 x0 = MAX((f32)min_x - 1.0f, bounds.min.x);
+			f32 x1 = MIN((f32)max_x + 2.0f, bounds.max.x);
+			f32 y0 = MAX((f32)y - 1.0f, bounds.min.y);
+			f32 y1 = MIN((f32)y + 2.0f, bounds.max.y);
+
+			points[point_count++] = math::vec2(x0, y0);
+			points[point_count++] = math::vec2(x1, y0);
+			points[point_count++] = math::vec2(x0, y1);
+			points[point_count++] = math::vec2(x1, y1);
+		}
+	}
+
+	math::Vec2 * hull = ALLOC_ARRAY(math::Vec2, point_count + 1, false);
+	u32 vert_count = build_convex_hull(points, point_count, hull);
+
+	b32 use_mesh = vert_count >= 3;
+	while(use_mesh && vert_count > SPRITE_MAX_MESH_VERTS) {
+		use_mesh = remove_cheapest_hull_edge(hull, &vert_count, bounds);
+	}
+
+	//NOTE: A mesh costs up to 3x the vertices of a quad so it has to save a decent chunk of the fill!!
+	f32 quad_area = sprite_dim.x * sprite_dim.y;
+	f32 mesh_area = use_mesh ? get_polygon_area(hull, vert_count) : quad_area;
+	if(mesh_area > (quad_area * 0.85f)) {
+		use_mesh = false;
+		mesh_area = quad_area;
+	}
+
+	rect->mesh_vert_count = 0;
+	if(use_mesh) {
+		rect->mesh_vert_count = vert_count;
+		for(u32 i = 0; i < vert_count; i++) {
+			rect->mesh_verts[i] = (hull[i] + math::vec2(pad)) / sprite_dim;
+		}
+	}
+
+	rect->quad_area = quad_area;
+	rect->mesh_area = mesh_area;
+
+	FREE_MEMORY(hull);
+	FREE_MEMORY(points);
+}
+
+//NOTE: Trims the source to its alpha bounds and keeps the pixels until the atlas is laid out, identical images share a rect!!
+u32 push_atlas_rect(TextureAtlas * atlas, Texture * src, PixelBounds * bounds) {
+	u32 width = (bounds->max_x + 1) - bounds->min_x;
+	u32 height = (bounds->max_y + 1) - bounds->min_y;
+	ASSERT(bounds->min_x <= bounds->max_x && width > 0 && height > 0);
+
+	Texture tex = {};
+	tex.width = width;
+	tex.height = height;
+	tex.size = width * height * TEXTURE_CHANNELS;
+	tex.ptr = ALLOC_ARRAY(u8, tex.size, false);
+	copy_pixel_rect(tex.ptr, width, 0, 0, src->ptr, src->width, bounds->min_x, bounds->min_y, width, height);
+	tex.hash = hash_texture(&tex);
+
+	u32 rect_index = U32_MAX;
+	for(u32 i = 0; i < atlas->rect_count; i++) {
+		if(atlas->rects[i].tex.hash == tex.hash && textures_are_equal(&atlas->rects[i].tex, &tex)) {
+			rect_index = i;
+			break;
+		}
+	}
+
+	if(rect_index == U32_MAX) {
+		ASSERT(atlas->rect_count < ARRAY_COUNT(atlas->rects));
+		rect_index = atlas->rect_count++;
+
+		AtlasRect * rect = atlas->rects + rect_index;
+		ZERO_STRUCT(rect);
+		rect->tex = tex;
+
+		build_sprite_mesh(rect);
+	}
+	else {
+		FREE_MEMORY(tex.ptr);
+	}
+
+	return rect_index;
+}
+
+AssetInfo * push_atlas_sprite(TextureAtlas * atlas, AssetId asset_id, u32 atlas_index, u32 rect_index) {
+	ASSERT(atlas->sprite_count < ARRAY_COUNT(atlas->sprites));
+	u32 sprite_index = atlas->sprite_count++;
+	atlas->sprite_rects[sprite_index] = rect_index;
+
+	AssetInfo * info = atlas->sprites + sprite_index;
+	info->id = asset_id;
+	info->type = AssetType_sprite;
+
+	AtlasRect * rect = atlas->rects + rect_index;
+	u32 pad_2 = TEXTURE_PADDING_PIXELS * 2;
+
+	SpriteInfo * sprite = &info->sprite;
+	sprite->atlas_index = atlas_index;
+	sprite->width = rect->tex.width + pad_2;
+	sprite->height = rect->tex.height + pad_2;
+	sprite->mesh_vert_count = rect->mesh_vert_count;
+
+	return info;
+}
+
+AssetInfo * pack_sprite_texture(TextureAtlas * atlas, AssetId asset_id, u32 atlas_index, Texture * src) {
+	PixelBounds bounds = find_alpha_bounds(src->ptr, src->width, src->height);
+	u32 rect_index = push_atlas_rect(atlas, src, &bounds);
+	AssetInfo * info = push_atlas_sprite(atlas, asset_id, atlas_index, rect_index);
+
+	u32 pad = TEXTURE_PADDING_PIXELS;
+	SpriteInfo * sprite = &info->sprite;
+	math::Rec2 trim_rec = math::rec2_min_dim(math::vec2((i32)bounds.min_x - (i32)pad, (i32)bounds.min_y - (i32)pad), math::vec2(sprite->width, sprite->height));
+	sprite->offset = math::rec_pos(trim_rec) - math::vec2(src->width, src->height) * 0.5f;
+
+	return info;
+}
+
+b32 try_layout_atlas(TextureAtlas * atlas, MaxRectsBin * bin, u32 * order, u32 width, u32 height) {
+	begin_max_rects_bin(bin, width, height);
+
+	b32 fits = true;
+	for(u32 i = 0; i < atlas->rect_count && fits; i++) {
+		AtlasRect * rect = atlas->rects + order[i];
+		fits = max_rects_insert(bin, rect->cell_width, rect->cell_height, atlas->allow_rotation, &rect->cell, &rect->rotated);
+	}
+
+	return fits;
+}
+
+void layout_atlas(TextureAtlas * atlas, u32 atlas_index) {
+	u32 pad = TEXTURE_PADDING_PIXELS;
+	u32 pad_2 = pad * 2;
+
+	//NOTE: Mipped atlases keep cells aligned and separated so the first few levels don't bleed into each other!!
+	u32 cell_align = 1;
+	u32 gutter = 0;
+	if(atlas->mipped) {
+		cell_align = 1 << (TEXTURE_MIP_GUTTER_LEVELS - 1);
+		gutter = cell_align;
+	}
+
+	u32 used_area = 0;
+	u32 * order = ALLOC_ARRAY(u32, atlas->rect_count, false);
+	for(u32 i = 0; i < atlas->rect_count; i++) {
+		AtlasRect * rect = atlas->rects + i;
+		rect->cell_width = ALIGN(rect->tex.width + pad_2, cell_align) + gutter;
+		rect->cell_height = ALIGN(rect->tex.height + pad_2, cell_align) + gutter;
+		used_area += (rect->tex.width + pad_2) * (rect->tex.height + pad_2);
+
+		//NOTE: Tallest first, ties broken on width then push order so the layout is deterministic!!
+		u32 ii = i;
+		for(; ii > 0; ii--) {
+			AtlasRect * other = atlas->rects + order[ii - 1];
+			if(other->cell_height > rect->cell_height || (other->cell_height == rect->cell_height && other->cell_width >= rect->cell_width)) {
+				break;
+			}
+
+			order[ii] = order[ii - 1];
+		}
+
+		order[ii] = i;
+	}
+
+	//NOTE: Smallest power of two that fits, growing the width first!!
+	MaxRectsBin bin = {};
+	u32 width = 64;
+	u32 height = 64;
+	while(!try_layout_atlas(atlas, &bin, order, width, height)) {
+		if(width == height) {
+			width *= 2;
+		}
+		else {
+			height *= 2;
+		}
+
+		ASSERT(height <= PACK_MAX_ATLAS_SIZE);
+	}
+
+	FREE_MEMORY(bin.free_rects);
+	FREE_MEMORY(order);
+
+	TextureFormat format = atlas->tex.format;
+	atlas->tex = allocate_texture(width, height, AssetId_atlas, atlas->sampling);
+	atlas->tex.format = format;
+	if(atlas->mipped) {
+		while(MAX(atlas->tex.width, atlas->tex.height) >> atlas->tex.mip_levels) {
+			atlas->tex.mip_levels++;
+		}
+	}
+
+	for(u32 i = 0; i < atlas->rect_count; i++) {
+		AtlasRect * rect = atlas->rects + i;
+		Texture * src = &rect->tex;
+
+		u32 x = rect->cell.x + pad;
+		u32 y = rect->cell.y + pad;
+		if(rect->rotated) {
+			//NOTE: Rotated 90 degrees so the source x axis runs down the atlas v axis!!
+			for(u32 sy = 0; sy < src->height; sy++) {
+				for(u32 sx = 0; sx < src->width; sx++) {
+					u8 * d = atlas->tex.ptr + ((y + (src->width - 1 - sx)) * atlas->tex.width + (x + sy)) * TEXTURE_CHANNELS;
+					u8 * s = src->ptr + (sy * src->width + sx) * TEXTURE_CHANNELS;
+					std::memcpy(d, s, TEXTURE_CHANNELS);
+				}
+			}
+		}
+		else {
+			copy_pixel_rect(atlas->tex.ptr, atlas->tex.width, x, y, src->ptr, src->width, 0, 0, src->width, src->height);
+		}
+
+		FREE_MEMORY(src->ptr);
+	}
+
+	math::Vec2 r_atlas_dim = math::vec2(1.0f / (f32)atlas->tex.width, 1.0f / (f32)atlas->tex.height);
+	for(u32 i = 0; i < atlas->sprite_count; i++) {
+		AtlasRect * rect = atlas->rects + atlas->sprite_rects[i];
+
+		u32 u_width = (rect->rotated ? rect->tex.height : rect->tex.width) + pad_2;
+		u32 v_height = (rect->rotated ? rect->tex.width : rect->tex.height) + pad_2;
+
+		SpriteInfo * sprite = &atlas->sprites[i].sprite;
+		sprite->rotated = rect->rotated;
+		sprite->tex_coords[0] = math::vec2(rect->cell.x, rect->cell.y) * r_atlas_dim;
+		sprite->tex_coords[1] = math::vec2(rect->cell.x + u_width, rect->cell.y + v_height) * r_atlas_dim;
+	}
+
+	//NOTE: Fill per sprite drawn once, meshes against the quads they replace!!
+	f32 quad_area = 0.0f;
+	f32 mesh_area = 0.0f;
+	u32 mesh_count = 0;
+	for(u32 i = 0; i < atlas->sprite_count; i++) {
+		AtlasRect * rect = atlas->rects + atlas->sprite_rects[i];
+		quad_area += rect->quad_area;
+		mesh_area += rect->mesh_area;
+		mesh_count += rect->mesh_vert_count ? 1 : 0;
+	}
+
+	f32 occupancy = (f32)used_area / (f32)(width * height) * 100.0f;
+	f32 fill = quad_area > 0.0f ? mesh_area / quad_area * 100.0f : 100.0f;
+	std::printf("LOG: atlas %u: %ux%u, %u sprites, %u unique, %.1f%% used, %u meshes, %.1f%% of quad fill\n", atlas_index, width, height, atlas->sprite_count, atlas->rect_count, occupancy, mesh_count, fill);
+}
+
+PackJob * push_pack_job(AssetPacker * packer, PackJobType type, char const * file_name, AssetId id) {
+	ASSERT(packer->job_count < ARRAY_COUNT(packer->jobs));
+
+	PackJob * job = packer->jobs + packer->job_count++;
+	ZERO_STRUCT(job);
+	job->type = type;
+	job->id = id;
+
+	//NOTE: Callers reuse their name buffers, so keep a copy until the job has run!!
+	ASSERT(std::strlen(file_name) < ARRAY_COUNT(job->file_name));
+	std::strcpy(job->file_name, file_name);
+
+	return job;
+}
+
+inline f32 get_parabola_intersection(f32 * f, u32 stride, i32 q, i32 p) {
+	return ((f[q * stride] + (f32)(q * q)) - (f[p * stride] + (f32)(p * p))) / (f32)(2 * (q - p));
+}
+
+//NOTE: Felzenszwalb/Huttenlocher 1D squared distance transform, f is 0 on features and FONT_SDF_INF elsewhere!!
+void squared_distance_transform_1d(f32 * f, u32 n, u32 stride, f32 * d, i32 * v, f32 * z) {
+	u32 k = 0;
+	v[0] = 0;
+	z[0] = -FONT_SDF_INF;
+	z[1] = FONT_SDF_INF;
+
+	for(u32 q = 1; q < n; q++) {
+		f32 s = get_parabola_intersection(f, stride, q, v[k]);
+		while(s <= z[k]) {
+			k--;
+			s = get_parabola_intersection(f, stride, q, v[k]);
+		}
+
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = FONT_SDF_INF;
+	}
+
+	k = 0;
+	for(u32 q = 0; q < n; q++) {
+		while(z[k + 1] < (f32)q) {
+			k++;
+		}
+
+		f32 delta = (f32)q - (f32)v[k];
+		d[q] = delta * delta + f[v[k] * stride];
+	}
+
+	for(u32 q = 0; q < n; q++) {
+		f[q * stride] = d[q];
+	}
+}
+
+void squared_distance_transform(f32 * grid, u32 width, u32 height) {
+	u32 n = MAX(width, height);
+	f32 * d = ALLOC_ARRAY(f32, n, false);
+	i32 * v = ALLOC_ARRAY(i32, n, false);
+	f32 * z = ALLOC_ARRAY(f32, n + 1, false);
+
+	for(u32 x = 0; x < width; x++) {
+		squared_distance_transform_1d(grid + x, height, width, d, v, z);
+	}
+
+	for(u32 y = 0; y < height; y++) {
+		squared_distance_transform_1d(grid + y * width, width, 1, d, v, z);
+	}
+
+	FREE_MEMORY(z);
+	FREE_MEMORY(v);
+	FREE_MEMORY(d);
+}
+
+i32 floor_div(i32 x, i32 y) {
+	return (x >= 0 ? x : x - (y - 1)) / y;
+}
+
+//NOTE: Coverage is rasterized FONT_SDF_UPSAMPLE times larger than the glyph set and box filtered down to a distance field!!
+void build_glyph_sdf(FontGlyphBitmap * bitmap, u8 * coverage, i32 width, i32 height, i32 x_offset, i32 y_offset) {
+	i32 up = FONT_SDF_UPSAMPLE;
+	i32 spread = FONT_SDF_SPREAD_PIXELS;
+
+	//NOTE: The high res grid starts on a multiple of the upsample factor so the glyph offsets stay whole pixels!!
+	i32 grid_x = floor_div(x_offset, up) - spread;
+	i32 grid_y = floor_div(y_offset, up) - spread;
+	i32 glyph_x = x_offset - grid_x * up;
+	i32 glyph_y = y_offset - grid_y * up;
+
+	u32 out_width = (u32)ALIGN(glyph_x + width + spread * up, up) / up;
+	u32 out_height = (u32)ALIGN(glyph_y + height + spread * up, up) / up;
+	u32 grid_width = out_width * up;
+	u32 grid_height = out_height * up;
+
+	f32 * to_inside = ALLOC_ARRAY(f32, grid_width * grid_height, false);
+	f32 * to_outside = ALLOC_ARRAY(f32, grid_width * grid_height, false);
+	for(u32 y = 0, i = 0; y < grid_height; y++) {
+		for(u32 x = 0; x < grid_width; x++, i++) {
+			i32 cx = (i32)x - glyph_x;
+			i32 cy = (i32)y - glyph_y;
+
+			b32 inside = cx >= 0 && cy >= 0 && cx < width && cy < height && coverage[cy * width + cx] >= 128;
+			to_inside[i] = inside ? 0.0f : FONT_SDF_INF;
+			to_outside[i] = inside ? FONT_SDF_INF : 0.0f;
+		}
+	}
+
+	squared_distance_transform(to_inside, grid_width, grid_height);
+	squared_distance_transform(to_outside, grid_width, grid_height);
+
+	Texture * tex = &bitmap->tex;
+	tex->width = out_width;
+	tex->height = out_height;
+	tex->sampling = TextureSampling_sdf;
+	tex->size = tex->width * tex->height * TEXTURE_CHANNELS;
+	tex->ptr = ALLOC_ARRAY(u8, tex->size, false);
+
+	f32 r_samples = 1.0f / (f32)(up * up);
+	for(u32 y = 0; y < out_height; y++) {
+		for(u32 x = 0; x < out_width; x++) {
+			f32 dist = 0.0f;
+			for(u32 sy = 0; sy < (u32)up; sy++) {
+				for(u32 sx = 0; sx < (u32)up; sx++) {
+					u32 i = (y * up + sy) * grid_width + (x * up + sx);
+					//NOTE: Edges sit half a pixel between the inside and outside pixel centres!!
+					dist += to_outside[i] > 0.0f ? std::sqrt(to_outside[i]) - 0.5f : 0.5f - std::sqrt(to_inside[i]);
+				}
+			}
+
+			dist *= r_samples / (f32)up;
+
+			f32 alpha = 0.5f + dist / (f32)(spread * 2);
+			alpha = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+			u8 a = (u8)(alpha * 255.0f + 0.5f);
+
+			//NOTE: Flipped to match the bottom up textures from stb_image!!
+			u8 * pixel = tex->ptr + (((out_height - 1) - y) * out_width + x) * TEXTURE_CHANNELS;
+			pixel[0] = a;
+			pixel[1] = a;
+			pixel[2] = a;
+			pixel[3] = a;
+		}
+	}
+
+	FREE_MEMORY(to_outside);
+	FREE_MEMORY(to_inside);
+
+	bitmap->x_offset = grid_x;
+	bitmap->y_offset = grid_y;
+}
+
+void rasterize_font(FontAsset * font_asset, PackJob * job) {
+	stbtt_fontinfo ttf_info;
+	MemoryPtr ttf_file = read_file_to_memory(job->file_name);
+	ASSERT(ttf_file.ptr);
+	stbtt_InitFont(&ttf_info, ttf_file.ptr, stbtt_GetFontOffsetForIndex(ttf_file.ptr, 0));
+
+	f32 scale_factor = stbtt_ScaleForPixelHeight(&ttf_info, job->pixel_height);
+
+	i32 ascent, descent, line_gap;
+	stbtt_GetFontVMetrics(&ttf_info, &ascent, &descent, &line_gap);
+	// std::printf("LOG: %f\n", line_gap * scale_factor);
+
+	i32 whitespace_advance;
+	stbtt_GetCodepointHMetrics(&ttf_info, ' ', &whitespace_advance, 0);
 
 	Font * font = &font_asset->font;
-	font->glyphs = ALLOC_ARRAY(FontGlyph, FONT_GLYPH_COUNT);
+	FontGlyph * glyphs = ALLOC_ARRAY(FontGlyph, FONT_GLYPH_COUNT);
+	font->glyphs = glyphs;
 	font->ascent = ascent * scale_factor;
 	font->descent = descent * scale_factor;
 	font->whitespace_advance = whitespace_advance * scale_factor;
-	font->atlas_index = packer->atlas_count++;
-	font->glyph_id = font_asset->id + 1;
 
-	TextureAtlas * atlas = packer->atlases + font->atlas_index;
-	atlas->tex = allocate_texture(384, 384, AssetId_atlas);
+	for(char code_point = FONT_FIRST_CHAR; code_point < FONT_ONE_PAST_LAST_CHAR; code_point++) {
+		i32 advance, left_side_bearing;
+		stbtt_GetCodepointHMetrics(&ttf_info, code_point, &advance, &left_side_bearing);
+
+		glyphs[get_font_glyph_index((char)code_point)].advance = advance * scale_factor;
+	}
+
+	//NOTE: Only the first font of each typeface in a pak builds the glyph set, other sizes scale it!!
+	if(job->rasterize_glyphs) {
+		f32 sdf_scale_factor = stbtt_ScaleForPixelHeight(&ttf_info, FONT_SDF_PIXEL_HEIGHT * FONT_SDF_UPSAMPLE);
+
+		job->glyph_bitmaps = ALLOC_ARRAY(FontGlyphBitmap, FONT_GLYPH_COUNT);
+
+		for(char code_point = FONT_FIRST_CHAR; code_point < FONT_ONE_PAST_LAST_CHAR; code_point++) {
+			FontGlyphBitmap * bitmap = job->glyph_bitmaps + get_font_glyph_index((char)code_point);
+
+			i32 bitmap_width, bitmap_height, x_offset, y_offset;
+			u8 * bitmap_data = stbtt_GetCodepointBitmap(&ttf_info, 0, sdf_scale_factor, code_point, &bitmap_width, &bitmap_height, &x_offset, &y_offset);
+			ASSERT(bitmap_data != 0);
+
+			build_glyph_sdf(bitmap, bitmap_data, bitmap_width, bitmap_height, x_offset, y_offset);
+
+			stbtt_FreeBitmap(bitmap_data, 0);
+		}
+	}
+
+	FREE_MEMORY(ttf_file.ptr);
+}
+
+void pack_font_glyphs(AssetPacker * packer, FontAsset * font_asset, PackJob * job) {
+	if(!job->rasterize_glyphs) {
+		return;
+	}
+
+	Font * font = &font_asset->font;
+	TextureAtlas * atlas = packer->atlases + font->atlas_index;
+
+	for(char code_point = FONT_FIRST_CHAR; code_point < FONT_ONE_PAST_LAST_CHAR; code_point++) {
+		FontGlyphBitmap * bitmap = job->glyph_bitmaps + get_font_glyph_index((char)code_point);
+		Texture * tex = &bitmap->tex;
+
+		math::Vec2 tex_dim = math::vec2(tex->width, tex->height);
+
+		//NOTE: Relative to the pen position, on top of whatever was trimmed off the distance field!!
+		AssetInfo * info = pack_sprite_texture(atlas, (AssetId)font->glyph_id, font->atlas_index, tex);
+		info->sprite.offset += math::vec2(tex_dim.x * 0.5f + bitmap->x_offset, -tex_dim.y * 0.5f - bitmap->y_offset);
+
+		FREE_MEMORY(tex->ptr);
+	}
+
+	FREE_MEMORY(job->glyph_bitmaps);
+}
+
+void pack_sprite_sheet_cells(AssetPacker * packer, PackJob * job) {
+	u32 atlas_index = job->index;
+	TextureAtlas * atlas = packer->atlases + atlas_index;
+
+	Texture * source_tex = &job->tex;
+	u32 sprite_width = job->sprite_width;
+	u32 sprite_height = job->sprite_height;
+
+	u32 sprites_in_row = source_tex->width / sprite_width;
+	u32 sprites_in_col = source_tex->height / sprite_height;
+
+	u32 sprites_to_pack = sprites_in_row * sprites_in_col;
+	if(sprites_to_pack > job->max_sprites) {
+		sprites_to_pack = job->max_sprites;
+	}
+
+	Texture blit_tex = {};
+	blit_tex.width = (u32)sprite_width;
+	blit_tex.height = (u32)sprite_height;
+	blit_tex.sampling = TextureSampling_bilinear;
+	blit_tex.size = blit_tex.width * blit_tex.height * TEXTURE_CHANNELS;
+	blit_tex.ptr = ALLOC_ARRAY(u8, blit_tex.size);
+
+	for(u32 i = 0; i < sprites_to_pack; i++) {
+		u32 y = i / sprites_in_row;
+		u32 x = i % sprites_in_row;
+
+		u32 u = x * sprite_width;
+		u32 v = (sprites_in_col - (y + 1)) * sprite_height;
+
+		copy_pixel_rect(blit_tex.ptr, blit_tex.width, 0, 0, source_tex->ptr, source_tex->width, u, v, sprite_width, sprite_height);
+
+		pack_sprite_texture(atlas, job->id, atlas_index, &blit_tex);
+	}
+
+	FREE_MEMORY(blit_tex.ptr);
+}
+
+u64 hash_file(u64 hash, char const * file_name) {
+	MemoryPtr file = read_file_to_memory(file_name);
+	if(!file.ptr) {
+		std::printf("ERROR: Could not find %s!!\n", file_name);
+		ASSERT(!"Pack input not found!");
+	}
+
+	hash = fnv1a_hash(hash, file.ptr, file.size);
+	FREE_MEMORY(file.ptr);
+
+	return hash;
+}
+
+//NOTE: Everything run_pack_job's output depends on, sprite sheet cells are cut in the serial stage so they're not part of this!!
+u64 hash_pack_job_input(PackJob * job) {
+	u32 params[4] = { PACK_CACHE_VERSION, (u32)job->type, (u32)job->sampling, job->rasterize_glyphs };
+
+	u64 hash = fnv1a_hash(FNV1A_SEED, params, sizeof(params));
+	hash = fnv1a_hash(hash, &job->pixel_height, sizeof(job->pixel_height));
+	return hash_file(hash, job->file_name);
+}
+
+u64 hash_asset_pack_inputs(AssetPacker * packer, char const * file_name) {
+	u32 version = PACK_CACHE_VERSION;
+	u64 hash = fnv1a_hash(FNV1A_SEED, &version, sizeof(version));
+	hash = fnv1a_hash(hash, file_name, std::strlen(file_name));
+
+	for(u32 i = 0; i < packer->atlas_count; i++) {
+		TextureAtlas * atlas = packer->atlases + i;
+		u32 params[4] = { (u32)atlas->sampling, (u32)atlas->tex.format, atlas->mipped, atlas->allow_rotation };
+		hash = fnv1a_hash(hash, params, sizeof(params));
+	}
+
+	for(u32 i = 0; i < packer->job_count; i++) {
+		PackJob * job = packer->jobs + i;
+		job->key = hash_pack_job_input(job);
+
+		u32 params[5] = { (u32)job->id, job->index, job->sprite_width, job->sprite_height, job->max_sprites };
+		hash = fnv1a_hash(hash, &job->key, sizeof(job->key));
+		hash = fnv1a_hash(hash, params, sizeof(params));
+	}
+
+	return hash;
+}
+
+void get_pack_cache_file_name(char * buf, u32 buf_size, u64 key) {
+	std::snprintf(buf, buf_size, PACK_CACHE_DIR "/%016llx.bin", (unsigned long long)key);
+}
+
+u32 get_pak_base_name_len(char const * file_name) {
+	char const * ext = std::strrchr(file_name, '.');
+	return ext ? (u32)(ext - file_name) : (u32)std::strlen(file_name);
+}
+
+//NOTE: What the game actually loads, either a compressed pak or a header with the pak as an array!!
+void get_pak_output_file_name(char * buf, u32 buf_size, char const * file_name, b32 embed) {
+	if(embed) {
+		std::snprintf(buf, buf_size, PACK_EMBED_DIR "/%.*s_pak.hpp", get_pak_base_name_len(file_name), file_name);
+	}
+	else {
+		std::snprintf(buf, buf_size, PACK_OUTPUT_DIR "/%.*s.pkz", get_pak_base_name_len(file_name), file_name);
+	}
+}
+
+void get_pak_key_file_name(char * buf, u32 buf_size, char const * file_name) {
+	std::snprintf(buf, buf_size, PACK_CACHE_DIR "/%s.key", file_name);
+}
+
+b32 asset_pack_is_up_to_date(char const * file_name, u64 pak_key, b32 embed) {
+	b32 up_to_date = false;
+
+	char key_file_name[256];
+	get_pak_key_file_name(key_file_name, ARRAY_COUNT(key_file_name), file_name);
+
+	MemoryPtr key_file = read_file_to_memory(key_file_name);
+	if(key_file.ptr) {
+		//NOTE: The game only ever sees the output file so that has to be there as well!!
+		char output_file_name[256];
+		get_pak_output_file_name(output_file_name, ARRAY_COUNT(output_file_name), file_name, embed);
+
+		std::FILE * pak_file_ptr = std::fopen(file_name, "rb");
+		std::FILE * output_file_ptr = std::fopen(output_file_name, "rb");
+		if(pak_file_ptr && output_file_ptr) {
+			up_to_date = key_file.size == sizeof(u64) && *(u64 *)key_file.ptr == pak_key;
+		}
+
+		if(pak_file_ptr) {
+			std::fclose(pak_file_ptr);
+		}
+
+		if(output_file_ptr) {
+			std::fclose(output_file_ptr);
+		}
+
+		FREE_MEMORY(key_file.ptr);
+	}
+
+	return up_to_date;
+}
+
+void write_pak_key(char const * file_name, u64 pak_key) {
+	char key_file_name[256];
+	get_pak_key_file_name(key_file_name, ARRAY_COUNT(key_file_name), file_name);
+
+	std::FILE * file_ptr = std::fopen(key_file_name, "wb");
+	if(file_ptr) {
+		std::fwrite(&pak_key, sizeof(u64), 1, file_ptr);
+		std::fclose(file_ptr);
+	}
+}
+
+void write_pack_cache_texture(std::FILE * file_ptr, Texture * tex) {
+	u32 params[4] = { tex->width, tex->height, (u32)tex->format, tex->size };
+	std::fwrite(params, sizeof(params), 1, file_ptr);
+	std::fwrite(&tex->hash, sizeof(tex->hash), 1, file_ptr);
+	std::fwrite(tex->ptr, tex->size, 1, file_ptr);
+}
+
+u8 * read_pack_cache_bytes(PackCacheReader * reader, size_t size) {
+	ASSERT((reader->pos + size) <= reader->file.size);
+	u8 * ptr = reader->file.ptr + reader->pos;
+	reader->pos += size;
+	return ptr;
+}
+
+#define READ_PACK_CACHE_STRUCT(reader, type) *(type *)read_pack_cache_bytes(reader, sizeof(type))
+
+void read_pack_cache_texture(PackCacheReader * reader, Texture * tex) {
+	tex->width = READ_PACK_CACHE_STRUCT(reader, u32);
+	tex->height = READ_PACK_CACHE_STRUCT(reader, u32);
+	tex->format = (TextureFormat)READ_PACK_CACHE_STRUCT(reader, u32);
+	tex->size = READ_PACK_CACHE_STRUCT(reader, u32);
+	tex->hash = READ_PACK_CACHE_STRUCT(reader, u64);
+	tex->mip_levels = 1;
+
+	tex->ptr = ALLOC_ARRAY(u8, tex->size, false);
+	std::memcpy(tex->ptr, read_pack_cache_bytes(reader, tex->size), tex->size);
+}
+
+//NOTE: Audio isn't cached, everything else is whatever run_pack_job produced for this key!!
+b32 read_pack_cache(AssetPacker * packer, PackJob * job) {
+	if(job->type == PackJobType_audio_clip) {
+		return false;
+	}
+
+	char cache_file_name[256];
+	get_pack_cache_file_name(cache_file_name, ARRAY_COUNT(cache_file_name), job->key);
+
+	PackCacheReader reader = {};
+	reader.file = read_file_to_memory(cache_file_name);
+	if(!reader.file.ptr) {
+		return false;
+	}
+
+	PackCacheHeader header = READ_PACK_CACHE_STRUCT(&reader, PackCacheHeader);
+	b32 valid = header.version == PACK_CACHE_VERSION && header.type == (u32)job->type && header.key == job->key;
+	if(valid) {
+		switch(job->type) {
+			case PackJobType_texture: {
+				Texture * texture = packer->textures + job->index;
+				ZERO_STRUCT(texture);
+				texture->id = job->id;
+				texture->sampling = job->sampling;
+				texture->alias_of = U32_MAX;
+				read_pack_cache_texture(&reader, texture);
+				break;
+			}
+
+			case PackJobType_sprite:
+			case PackJobType_sprite_sheet: {
+				read_pack_cache_texture(&reader, &job->tex);
+				break;
+			}
+
+			case PackJobType_font: {
+				Font * font = &packer->fonts[job->index].font;
+				font->ascent = READ_PACK_CACHE_STRUCT(&reader, f32);
+				font->descent = READ_PACK_CACHE_STRUCT(&reader, f32);
+				font->whitespace_advance = READ_PACK_CACHE_STRUCT(&reader, f32);
+
+				FontGlyph * glyphs = ALLOC_ARRAY(FontGlyph, FONT_GLYPH_COUNT);
+				std::memcpy(glyphs, read_pack_cache_bytes(&reader, sizeof(FontGlyph) * FONT_GLYPH_COUNT), sizeof(FontGlyph) * FONT_GLYPH_COUNT);
+				font->glyphs = glyphs;
+
+				if(job->rasterize_glyphs) {
+					job->glyph_bitmaps = ALLOC_ARRAY(FontGlyphBitmap, FONT_GLYPH_COUNT);
+					for(u32 i = 0; i < FONT_GLYPH_COUNT; i++) {
+						FontGlyphBitmap * bitmap = job->glyph_bitmaps + i;
+						bitmap->x_offset = READ_PACK_CACHE_STRUCT(&reader, i32);
+						bitmap->y_offset = READ_PACK_CACHE_STRUCT(&reader, i32);
+						bitmap->tex.sampling = TextureSampling_sdf;
+						read_pack_cache_texture(&reader, &bitmap->tex);
+					}
+				}
 
-	f32 r_tex_size = 1.0f / (f32)atlas->tex.width;
+				break;
+			}
 
-	//TODO: Collapse this!!
-	for(char code_point = FONT_FIRST_CHAR; code_point < FONT_ONE_PAST_LAST_CHAR; code_point++) {
-		FontGlyph * glyph = font->glyphs + get_font_glyph_index((char)code_point);
+			case PackJobType_tile_map: {
+				TileMapAsset * map_asset = packer->tile_maps + job->index;
+				map_asset->id = job->id;
+				TileMap * map = &map_asset->map;
+				map->width = READ_PACK_CACHE_STRUCT(&reader, u32);
+				map->spawn_count = READ_PACK_CACHE_STRUCT(&reader, u32);
+				u32 * column_offsets = ALLOC_ARRAY(u32, map->width + 1);
+				TileSpawn * spawns = ALLOC_ARRAY(TileSpawn, MAX(map->spawn_count, 1));
+				std::memcpy(column_offsets, read_pack_cache_bytes(&reader, sizeof(u32) * (map->width + 1)), sizeof(u32) * (map->width + 1));
+				std::memcpy(spawns, read_pack_cache_bytes(&reader, sizeof(TileSpawn) * map->spawn_count), sizeof(TileSpawn) * map->spawn_count);
+				map->column_offsets = column_offsets;
+				map->spawns = spawns;
+				break;
+			}
 
-		i32 bitmap_width, bitmap_height;
-		i32 x_offset, y_offset;
-		u8 * bitmap_data = stbtt_GetCodepointBitmap(&ttf_info, 0, scale_factor, code_point, &bitmap_width, &bitmap_height, &x_offset, &y_offset);
-		ASSERT(bitmap_data != 0);
+			INVALID_CASE();
+		}
+	}
 
-		i32 advance, left_side_bearing;
-		stbtt_GetCodepointHMetrics(&ttf_info, code_point, &advance, &left_side_bearing);
+	FREE_MEMORY(reader.file.ptr);
+	return valid;
+}
+
+void write_pack_cache(AssetPacker * packer, PackJob * job) {
+	if(job->type == PackJobType_audio_clip) {
+		return;
+	}
+
+	//NOTE: Written under a per-job name and renamed so jobs with the same key never see a partial file!!
+	char cache_file_name[256];
+	get_pack_cache_file_name(cache_file_name, ARRAY_COUNT(cache_file_name), job->key);
+
+	//NOTE: Room for the suffix, a truncated name could get renamed onto some other cache file so skip the write instead!!
+	char tmp_file_name[ARRAY_COUNT(cache_file_name) + 16];
+	i32 tmp_file_name_len = std::snprintf(tmp_file_name, ARRAY_COUNT(tmp_file_name), "%s.%u.tmp", cache_file_name, (u32)(job - packer->jobs));
+	if(tmp_file_name_len < 0 || tmp_file_name_len >= (i32)ARRAY_COUNT(tmp_file_name)) {
+		return;
+	}
+
+	std::FILE * file_ptr = std::fopen(tmp_file_name, "wb");
+	if(!file_ptr) {
+		return;
+	}
 
-		glyph->advance = advance * scale_factor;
+	PackCacheHeader header = {};
+	header.version = PACK_CACHE_VERSION;
+	header.type = (u32)job->type;
+	header.key = job->key;
+	std::fwrite(&header, sizeof(PackCacheHeader), 1, file_ptr);
 
-		Texture tex = {};
-		tex.width = (u32)bitmap_width;
-		tex.height = (u32)bitmap_height;
-		tex.sampling = TextureSampling_bilinear;
-		tex.size = tex.width * tex.height * TEXTURE_CHANNELS;
-		tex.ptr = ALLOC_ARRAY(u8, tex.size);
+	switch(job->type) {
+		case PackJobType_texture: {
+			write_pack_cache_texture(file_ptr, packer->textures + job->index);
+			break;
+		}
 
-		for(u32 y = 0, i = 0; y < tex.height; y++) {
-			for(u32 x = 0; x < tex.width; x++, i += TEXTURE_CHANNELS) {
-				u8 a = bitmap_data[((tex.height - 1) - y) * tex.width + x];
+		case PackJobType_sprite:
+		case PackJobType_sprite_sheet: {
+			write_pack_cache_texture(file_ptr, &job->tex);
+			break;
+		}
 
-				tex.ptr[i + 0] = a;
-				tex.ptr[i + 1] = a;
-				tex.ptr[i + 2] = a;
-				tex.ptr[i + 3] = a;
+		case PackJobType_font: {
+			Font * font = &packer->fonts[job->index].font;
+			std::fwrite(&font->ascent, sizeof(f32), 1, file_ptr);
+			std::fwrite(&font->descent, sizeof(f32), 1, file_ptr);
+			std::fwrite(&font->whitespace_advance, sizeof(f32), 1, file_ptr);
+			std::fwrite(font->glyphs, sizeof(FontGlyph), FONT_GLYPH_COUNT, file_ptr);
+
+			for(u32 i = 0; i < FONT_GLYPH_COUNT && job->rasterize_glyphs; i++) {
+				FontGlyphBitmap * bitmap = job->glyph_bitmaps + i;
+				std::fwrite(&bitmap->x_offset, sizeof(i32), 1, file_ptr);
+				std::fwrite(&bitmap->y_offset, sizeof(i32), 1, file_ptr);
+				write_pack_cache_texture(file_ptr, &bitmap->tex);
 			}
+
+			break;
 		}
 
-		math::Vec2 tex_dim = math::vec2(tex.width, tex.height);
+		case PackJobType_tile_map: {
+			TileMap * map = &packer->tile_maps[job->index].map;
+			std::fwrite(&map->width, sizeof(u32), 1, file_ptr);
+			std::fwrite(&map->spawn_count, sizeof(u32), 1, file_ptr);
+			std::fwrite(map->column_offsets, sizeof(u32), map->width + 1, file_ptr);
+			std::fwrite(map->spawns, sizeof(TileSpawn), map->spawn_count, file_ptr);
+			break;
+		}
 
-		Blit blit = blit_texture(&atlas->tex, &tex);
+		INVALID_CASE();
+	}
 
-		ASSERT(atlas->sprite_count < ARRAY_COUNT(atlas->sprites));
-		AssetInfo * info = atlas->sprites + atlas->sprite_count++;
-		info->id = (AssetId)font->glyph_id;
-		info->type = AssetType_sprite;
+	std::fclose(file_ptr);
 
-		SpriteInfo * sprite = &info->sprite;
-		sprite->atlas_index = font->atlas_index;
-		sprite->width = blit.width;
-		sprite->height = blit.height;
-		sprite->offset = math::vec2(tex_dim.x * 0.5f + x_offset, -tex_dim.y * 0.5f - y_offset);
-		sprite->tex_coords[0] = math::vec2(blit.u, blit.v) * r_tex_size;
-		sprite->tex_coords[1] = math::vec2(blit.u + blit.width, blit.v + blit.height) * r_tex_size;
+	if(std::rename(tmp_file_name, cache_file_name) != 0) {
+		std::remove(tmp_file_name);
+	}
+}
 
-		stbtt_FreeBitmap(bitmap_data, 0);
-		FREE_MEMORY(tex.ptr);
+//NOTE: Runs on the worker threads, must only touch the job and the packer slot it owns!!
+void run_pack_job(AssetPacker * packer, PackJob * job) {
+	if(read_pack_cache(packer, job)) {
+		atomic_fetch_add_u32(&packer->cache_hit_count, 1);
+		return;
 	}
 
-	FREE_MEMORY(ttf_file.ptr);
+	switch(job->type) {
+		case PackJobType_texture: {
+			Texture * texture = packer->textures + job->index;
+			*texture = load_texture(job->file_name, job->id, job->sampling);
+			if(texture_is_opaque(texture)) {
+				texture->format = TextureFormat_rgb565;
+			}
+
+			texture->hash = hash_texture(texture);
+			texture->alias_of = U32_MAX;
+
+			break;
+		}
+
+		case PackJobType_sprite:
+		case PackJobType_sprite_sheet: {
+			job->tex = load_texture(job->file_name, AssetId_null);
+			break;
+		}
+
+		case PackJobType_font: {
+			rasterize_font(packer->fonts + job->index, job);
+			break;
+		}
+
+		case PackJobType_audio_clip: {
+			packer->audio_clips[job->index] = load_audio_clip(job->file_name, job->id);
+			break;
+		}
+
+		case PackJobType_tile_map: {
+			packer->tile_maps[job->index] = load_tile_map(job->file_name, job->id);
+			break;
+		}
+
+		INVALID_CASE();
+	}
+
+	write_pack_cache(packer, job);
+}
+
+//NOTE: Runs serially in the order the jobs were pushed so atlas placement and output don't depend on thread timing!!
+void finish_pack_job(AssetPacker * packer, PackJob * job) {
+	switch(job->type) {
+		case PackJobType_texture: {
+			//NOTE: Identical textures are only written once, later copies alias the first!!
+			Texture * texture = packer->textures + job->index;
+			for(u32 i = 0; i < job->index; i++) {
+				Texture * other = packer->textures + i;
+				if(other->alias_of == U32_MAX && other->hash == texture->hash && other->sampling == texture->sampling && textures_are_equal(other, texture)) {
+					texture->alias_of = i;
+					break;
+				}
+			}
+
+			break;
+		}
+
+		case PackJobType_sprite: {
+			TextureAtlas * atlas = packer->atlases + job->index;
+
+			pack_sprite_texture(atlas, job->id, job->index, &job->tex);
+
+			FREE_MEMORY(job->tex.ptr);
+			break;
+		}
+
+		case PackJobType_sprite_sheet: {
+			pack_sprite_sheet_cells(packer, job);
+
+			FREE_MEMORY(job->tex.ptr);
+			break;
+		}
+
+		case PackJobType_font: {
+			pack_font_glyphs(packer, packer->fonts + job->index, job);
+			break;
+		}
+
+		case PackJobType_audio_clip:
+		case PackJobType_tile_map: {
+			break;
+		}
+
+		INVALID_CASE();
+	}
+}
+
+void run_parallel_work_on_this_thread(ParallelWork * work) {
+	while(true) {
+		u32 index = atomic_fetch_add_u32(&work->next_index, 1);
+		if(index >= work->count) {
+			break;
+		}
+
+		work->proc(work->data, index);
+	}
+}
+
+#ifdef WIN32
+DWORD WINAPI parallel_worker_thread_proc(LPVOID param) {
+	run_parallel_work_on_this_thread((ParallelWork *)param);
+	return 0;
+}
+#else
+void * parallel_worker_thread_proc(void * param) {
+	run_parallel_work_on_this_thread((ParallelWork *)param);
+	return 0;
+}
+#endif
+
+//NOTE: Calls proc once for every index in [0, count) spread across all the cores, returns when they're all done!!
+void run_parallel(ParallelProc * proc, void * data, u32 count) {
+	ParallelWork work = {};
+	work.proc = proc;
+	work.data = data;
+	work.count = count;
+	work.next_index = 0;
+
+	u32 thread_count = MIN(get_processor_count(), PACK_MAX_THREADS);
+	thread_count = MIN(thread_count, count);
+
+	//NOTE: This thread does its share of the work too!!
+	PackThread threads[PACK_MAX_THREADS];
+	for(u32 i = 1; i < thread_count; i++) {
+#ifdef WIN32
+		threads[i] = CreateThread(0, 0, parallel_worker_thread_proc, &work, 0, 0);
+		ASSERT(threads[i]);
+#else
+		i32 result = pthread_create(threads + i, 0, parallel_worker_thread_proc, &work);
+		ASSERT(result == 0);
+#endif
+	}
+
+	run_parallel_work_on_this_thread(&work);
+
+	for(u32 i = 1; i < thread_count; i++) {
+#ifdef WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else
+		pthread_join(threads[i], 0);
+#endif
+	}
+}
+
+void run_pack_job_proc(void * data, u32 index) {
+	AssetPacker * packer = (AssetPacker *)data;
+	run_pack_job(packer, packer->jobs + index);
+}
+
+void run_pack_jobs(AssetPacker * packer) {
+	packer->cache_hit_count = 0;
+
+	run_parallel(run_pack_job_proc, packer, packer->job_count);
+
+	for(u32 i = 0; i < packer->job_count; i++) {
+		finish_pack_job(packer, packer->jobs + i);
+	}
+
+	packer->job_count = 0;
+}
+
+void compress_pack_block_proc(void * data, u32 index) {
+	PackBlock * block = (PackBlock *)data + index;
+
+	//NOTE: Raw deflate, the header already says how big every block is!!
+	mz_uint flags = tdefl_create_comp_flags_from_zip_params(PACK_COMPRESSION_LEVEL, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+	block->dst = (u8 *)tdefl_compress_mem_to_heap(block->src, block->src_size, &block->dst_size, flags);
+	ASSERT(block->dst);
+}
+
+//NOTE: Deflates the pak in independent blocks on every core, the runtime can inflate them in any order!!
+void write_compressed_asset_pack(char const * file_name, char const * compressed_file_name) {
+	MemoryPtr pak = read_file_to_memory(file_name);
+	ASSERT(pak.ptr);
+
+	CompressedAssetPackHeader header = {};
+	header.size = (u32)pak.size;
+	header.block_size = ASSET_PACK_BLOCK_SIZE;
+	header.block_count = (header.size + header.block_size - 1) / header.block_size;
+
+	PackBlock * blocks = ALLOC_ARRAY(PackBlock, header.block_count);
+	for(u32 i = 0; i < header.block_count; i++) {
+		PackBlock * block = blocks + i;
+		block->src = pak.ptr + i * header.block_size;
+		block->src_size = MIN(header.block_size, header.size - i * header.block_size);
+	}
+
+	run_parallel(compress_pack_block_proc, blocks, header.block_count);
+
+	std::FILE * file_ptr = std::fopen(compressed_file_name, "wb");
+	ASSERT(file_ptr != 0);
+
+	std::fwrite(&header, sizeof(CompressedAssetPackHeader), 1, file_ptr);
+
+	size_t compressed_size = sizeof(CompressedAssetPackHeader) + sizeof(u32) * header.block_count;
+	for(u32 i = 0; i < header.block_count; i++) {
+		u32 block_size = (u32)blocks[i].dst_size;
+		std::fwrite(&block_size, sizeof(u32), 1, file_ptr);
+	}
+
+	for(u32 i = 0; i < header.block_count; i++) {
+		std::fwrite(blocks[i].dst, 1, blocks[i].dst_size, file_ptr);
+		compressed_size += blocks[i].dst_size;
+
+		mz_free(blocks[i].dst);
+	}
+
+	std::fclose(file_ptr);
+
+	std::printf("LOG: %s: %u blocks, %u -> %u bytes\n", compressed_file_name, header.block_count, header.size, (u32)compressed_size);
+
+	FREE_MEMORY(blocks);
+	FREE_MEMORY(pak.ptr);
+}
+
+void push_font(AssetPacker * packer, char const * file_name, AssetId font_id, f32 pixel_height) {
+	ASSERT(packer->font_count < ARRAY_COUNT(packer->fonts));
+
+	//NOTE: Every font in the pak shares one atlas so text doesn't switch textures between fonts!!
+	if(!packer->font_count) {
+		ASSERT(packer->atlas_count < ARRAY_COUNT(packer->atlases));
+		packer->font_atlas_index = packer->atlas_count++;
+
+		TextureAtlas * atlas = packer->atlases + packer->font_atlas_index;
+		atlas->sampling = TextureSampling_sdf;
+		atlas->allow_rotation = true;
+		//NOTE: The distance is the same in every channel so only luminance and alpha need to be stored!!
+		atlas->tex.format = TextureFormat_luminance_alpha;
+	}
+
+	u32 font_index = packer->font_count++;
+	FontAsset * font_asset = packer->fonts + font_index;
+	font_asset->id = font_id;
+
+	Font * font = &font_asset->font;
+	font->atlas_index = packer->font_atlas_index;
+	font->glyph_id = font_asset->id + 1;
+	font->glyph_scale = pixel_height / FONT_SDF_PIXEL_HEIGHT;
+
+	b32 rasterize_glyphs = true;
+	for(u32 i = 0; i < packer->job_count; i++) {
+		PackJob * other = packer->jobs + i;
+		if(other->type == PackJobType_font && other->rasterize_glyphs && std::strcmp(other->file_name, file_name) == 0) {
+			font->glyph_id = packer->fonts[other->index].font.glyph_id;
+			rasterize_glyphs = false;
+			break;
+		}
+	}
+
+	PackJob * job = push_pack_job(packer, PackJobType_font, file_name, font_id);
+	job->index = font_index;
+	job->pixel_height = pixel_height;
+	job->rasterize_glyphs = rasterize_glyphs;
 }
 
 void push_texture(AssetPacker * packer, char * file_name, AssetId asset_id, TextureSampling sampling = TextureSampling_bilinear) {
 	ASSERT(packer->texture_count < ARRAY_COUNT(packer->textures));
 
-	Texture * texture = packer->textures + packer->texture_count++;
-	*texture = load_texture(file_name, asset_id, sampling);
+	PackJob * job = push_pack_job(packer, PackJobType_texture, file_name, asset_id);
+	job->index = packer->texture_count++;
+	job->sampling = sampling;
 }
 
 void push_audio_clip(AssetPacker * packer, char * file_name, AssetId asset_id) {
 	ASSERT(packer->audio_clip_count < ARRAY_COUNT(packer->audio_clips));
 
-	AudioClip * audio_clip = packer->audio_clips + packer->audio_clip_count++;
-	*audio_clip = load_audio_clip(file_name, asset_id);
+	PackJob * job = push_pack_job(packer, PackJobType_audio_clip, file_name, asset_id);
+	job->index = packer->audio_clip_count++;
 }
 
 void push_tile_map(AssetPacker * packer, char * file_name, AssetId asset_id) {
 	ASSERT(packer->tile_map_count < ARRAY_COUNT(packer->tile_maps));
 
-	TileMapAsset * tile_map = packer->tile_maps + packer->tile_map_count++;
-	*tile_map = load_tile_map(file_name, asset_id);
+	PackJob * job = push_pack_job(packer, PackJobType_tile_map, file_name, asset_id);
+	job->index = packer->tile_map_count++;
 }
 
 void begin_packed_texture(AssetPacker * packer, TextureSampling sampling = TextureSampling_bilinear) {
@@ -511,71 +2158,93 @@ void begin_packed_texture(AssetPacker * packer, TextureSampling sampling = Textu
 
 	u32 atlas_index = packer->atlas_count++;
 	TextureAtlas * atlas = packer->atlases + atlas_index;
-	atlas->tex = allocate_texture(1536, 1536, AssetId_atlas, sampling);
+	atlas->sampling = sampling;
+	atlas->allow_rotation = true;
+	//NOTE: Atlases are always power of two, which is all WebGL needs to mip them!!
+	atlas->mipped = sampling == TextureSampling_bilinear;
 }
 
 void pack_sprite(AssetPacker * packer, char * file_name, AssetId asset_id) {
 	ASSERT(packer->atlas_count);
 
-	u32 atlas_index = packer->atlas_count - 1;
-	TextureAtlas * atlas = packer->atlases + atlas_index;
-
-	Texture blit_tex = load_texture(file_name, AssetId_null);
-	Blit blit = blit_texture(&atlas->tex, &blit_tex);
-
-	push_sprite(atlas, asset_id, atlas_index, &blit, math::vec2(blit_tex.width, blit_tex.height));
+	PackJob * job = push_pack_job(packer, PackJobType_sprite, file_name, asset_id);
+	job->index = packer->atlas_count - 1;
 }
 
 void pack_sprite_sheet(AssetPacker * packer, char const * file_name, AssetId sprite_id, u32 sprite_width, u32 sprite_height, u32 max_sprites_to_pack = U32_MAX) {
 	ASSERT(packer->atlas_count);
 
-	u32 atlas_index = packer->atlas_count - 1;
-	TextureAtlas * atlas = packer->atlases + atlas_index;
+	PackJob * job = push_pack_job(packer, PackJobType_sprite_sheet, file_name, sprite_id);
+	job->index = packer->atlas_count - 1;
+	job->sprite_width = sprite_width;
+	job->sprite_height = sprite_height;
+	job->max_sprites = max_sprites_to_pack;
+}
 
-	Texture source_tex = load_texture(file_name, AssetId_null);
+//NOTE: Embedded paks skip compression, the game reads them in place so they only need to be aligned!!
+void write_embedded_asset_pack(char const * file_name, char const * header_file_name) {
+	MemoryPtr pak = read_file_to_memory(file_name);
+	ASSERT(pak.ptr);
 
-	math::Vec2 sprite_dim = math::vec2(sprite_width, sprite_height);
-	u32 sprites_in_row = source_tex.width / sprite_width;
-	u32 sprites_in_col = source_tex.height / sprite_height;
+	u32 base_len = get_pak_base_name_len(file_name);
 
-	u32 sprites_to_pack = sprites_in_row * sprites_in_col;
-	if(sprites_to_pack > max_sprites_to_pack) {
-		sprites_to_pack = max_sprites_to_pack;
+	char guard_name[256];
+	u32 guard_len = MIN(base_len, ARRAY_COUNT(guard_name) - 1);
+	for(u32 i = 0; i < guard_len; i++) {
+		char c = file_name[i];
+		guard_name[i] = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
 	}
+	guard_name[guard_len] = 0;
 
-	Texture blit_tex = {};
-	blit_tex.width = (u32)sprite_width;
-	blit_tex.height = (u32)sprite_height;
-	blit_tex.sampling = TextureSampling_bilinear;
-	blit_tex.size = blit_tex.width * blit_tex.height * TEXTURE_CHANNELS;
-	blit_tex.ptr = ALLOC_ARRAY(u8, blit_tex.size);
+	std::FILE * file_ptr = std::fopen(header_file_name, "wb");
+	ASSERT(file_ptr != 0);
 
-	for(u32 i = 0; i < sprites_to_pack; i++) {
-		u32 y = i / sprites_in_row;
-		u32 x = i % sprites_in_row;
+	std::fprintf(file_ptr, "//NOTE: Generated by the asset packer from %s, don't edit!!\n\n", file_name);
+	std::fprintf(file_ptr, "#ifndef %s_PAK_HPP_INCLUDED\n#define %s_PAK_HPP_INCLUDED\n\n", guard_name, guard_name);
+	std::fprintf(file_ptr, "alignas(16) static constexpr u8 %.*s_pak[%u] = {\n", base_len, file_name, (u32)pak.size);
 
-		u32 u = x * sprite_width;
-		u32 v = (sprites_in_col - (y + 1)) * sprite_height;
+	for(u32 i = 0; i < pak.size; i++) {
+		if(i % 32 == 0) {
+			std::fprintf(file_ptr, "\t");
+		}
 
-		for(u32 yy = 0, ii = 0; yy < sprite_height; yy++) {
-			for(u32 xx = 0; xx < sprite_width; xx++, ii += 4) {
-				u32 kk = ((v + yy) * source_tex.width + (u + xx)) * 4;
+		std::fprintf(file_ptr, "0x%02x,", pak.ptr[i]);
 
-				blit_tex.ptr[ii + 0] = source_tex.ptr[kk + 0];
-				blit_tex.ptr[ii + 1] = source_tex.ptr[kk + 1];
-				blit_tex.ptr[ii + 2] = source_tex.ptr[kk + 2];
-				blit_tex.ptr[ii + 3] = source_tex.ptr[kk + 3];
-			}
+		if(i % 32 == 31 || i == pak.size - 1) {
+			std::fprintf(file_ptr, "\n");
 		}
-
-		Blit blit = blit_texture(&atlas->tex, &blit_tex);
-		push_sprite(atlas, sprite_id, atlas_index, &blit, math::vec2(blit_tex.width, blit_tex.height));
 	}
 
-	FREE_MEMORY(blit_tex.ptr);
+	std::fprintf(file_ptr, "};\n\n#endif\n");
+	std::fclose(file_ptr);
+
+	std::printf("LOG: %s: %u bytes\n", header_file_name, (u32)pak.size);
+
+	FREE_MEMORY(pak.ptr);
 }
 
-void write_out_asset_pack(AssetPacker * packer, char * file_name) {
+void write_out_asset_pack(AssetPacker * packer, char * file_name, b32 embed = false) {
+	//NOTE: Nothing to do if the inputs and parameters match the last time this pak was written!!
+	u64 pak_key = hash_asset_pack_inputs(packer, file_name);
+	if(asset_pack_is_up_to_date(file_name, pak_key, embed)) {
+		std::printf("LOG: %s is up to date\n", file_name);
+		ZERO_STRUCT(packer);
+		return;
+	}
+
+	//NOTE: Drop the old key first so a pak that fails to write is never treated as up to date!!
+	char key_file_name[256];
+	get_pak_key_file_name(key_file_name, ARRAY_COUNT(key_file_name), file_name);
+	std::remove(key_file_name);
+
+	u32 job_count = packer->job_count;
+	run_pack_jobs(packer);
+	std::printf("LOG: %s: %u of %u jobs from cache\n", file_name, packer->cache_hit_count, job_count);
+
+	for(u32 i = 0; i < packer->atlas_count; i++) {
+		layout_atlas(packer->atlases + i, i);
+	}
+
 	std::FILE * file_ptr = std::fopen(file_name, "wb");
 	ASSERT(file_ptr != 0);
 
@@ -601,14 +2270,21 @@ void write_out_asset_pack(AssetPacker * packer, char * file_name) {
 		info.texture.height = tex->height;
 		info.texture.offset = math::vec2(0.0f);
 		info.texture.sampling = tex->sampling;
+		info.texture.format = tex->format;
+		info.texture.mip_levels = tex->mip_levels;
 
 		std::fwrite(&info, sizeof(AssetInfo), 1, file_ptr);
-		std::fwrite(tex->ptr, tex->size, 1, file_ptr);
+		write_texture_data(tex, file_ptr);
 	}
 
 	for(u32 i = 0; i < packer->atlas_count; i++) {
 		TextureAtlas * atlas = packer->atlases + i;
-		std::fwrite(atlas->sprites, sizeof(AssetInfo), atlas->sprite_count, file_ptr);
+		for(u32 ii = 0; ii < atlas->sprite_count; ii++) {
+			AtlasRect * rect = atlas->rects + atlas->sprite_rects[ii];
+
+			std::fwrite(atlas->sprites + ii, sizeof(AssetInfo), 1, file_ptr);
+			std::fwrite(rect->mesh_verts, sizeof(math::Vec2), rect->mesh_vert_count, file_ptr);
+		}
 	}
 
 	for(u32 i = 0; i < packer->texture_count; i++) {
@@ -620,19 +2296,37 @@ void write_out_asset_pack(AssetPacker * packer, char * file_name) {
 		info.texture.width = tex->width;
 		info.texture.height = tex->height;
 		info.texture.sampling = tex->sampling;
+		info.texture.format = tex->format;
+		info.texture.mip_levels = tex->mip_levels;
 
-		std::fwrite(&info, sizeof(AssetInfo), 1, file_ptr);
-		std::fwrite(tex->ptr, tex->size, 1, file_ptr);
+		if(tex->alias_of != U32_MAX) {
+			Texture * alias_tex = packer->textures + tex->alias_of;
+			info.texture.alias_id = alias_tex->id;
+
+			//NOTE: Index within the asset group, which is contiguous in the pak!!
+			for(u32 ii = 0; ii < tex->alias_of; ii++) {
+				if(packer->textures[ii].id == alias_tex->id) {
+					info.texture.alias_index++;
+				}
+			}
+
+			std::fwrite(&info, sizeof(AssetInfo), 1, file_ptr);
+		}
+		else {
+			std::fwrite(&info, sizeof(AssetInfo), 1, file_ptr);
+			write_texture_data(tex, file_ptr);
+		}
 	}
 
 #if PACK_AUDIO_ASSETS
-	for(u32 i = 0; i < ARRAY_COUNT(clips); i++) {
-		AudioClip * clip = clips + i;
+	for(u32 i = 0; i < packer->audio_clip_count; i++) {
+		AudioClip * clip = packer->audio_clips + i;
 
 		AssetInfo info = {};
 		info.id = clip->id;
 		info.type = AssetType_audio_clip;
 		info.audio_clip.samples = clip->samples;
+		info.audio_clip.channels = clip->channels;
 		info.audio_clip.size = clip->size;
 
 		std::fwrite(&info, sizeof(AssetInfo), 1, file_ptr);
@@ -647,9 +2341,15 @@ void write_out_asset_pack(AssetPacker * packer, char * file_name) {
 		info.id = map_asset->id;
 		info.type = AssetType_tile_map;
 		info.tile_map.width = map_asset->map.width;
+		info.tile_map.spawn_count = map_asset->map.spawn_count;
 
 		std::fwrite(&info, sizeof(AssetInfo), 1, file_ptr);
-		std::fwrite(map_asset->map.tiles, sizeof(Tiles), map_asset->map.width, file_ptr);
+		std::fwrite(map_asset->map.column_offsets, sizeof(u32), map_asset->map.width + 1, file_ptr);
+		std::fwrite(map_asset->map.spawns, sizeof(TileSpawn), map_asset->map.spawn_count, file_ptr);
+
+		u32 spawn_size = sizeof(TileSpawn) * map_asset->map.spawn_count;
+		u32 padding = 0;
+		std::fwrite(&padding, 1, ALIGN4(spawn_size) - spawn_size, file_ptr);
 	}
 
 	for(u32 i = 0; i < packer->font_count; i++) {
@@ -664,16 +2364,279 @@ void write_out_asset_pack(AssetPacker * packer, char * file_name) {
 		info.font.descent = font->descent;
 		info.font.whitespace_advance = font->whitespace_advance;
 		info.font.atlas_index = font->atlas_index;
+		info.font.glyph_scale = font->glyph_scale;
 
 		std::fwrite(&info, sizeof(AssetInfo), 1, file_ptr);
 		std::fwrite(font->glyphs, sizeof(FontGlyph), FONT_GLYPH_COUNT, file_ptr);
 	}
 
 	std::fclose(file_ptr);
+
+	char output_file_name[256];
+	get_pak_output_file_name(output_file_name, ARRAY_COUNT(output_file_name), file_name, embed);
+	if(embed) {
+		write_embedded_asset_pack(file_name, output_file_name);
+	}
+	else {
+		write_compressed_asset_pack(file_name, output_file_name);
+	}
+
+	write_pak_key(file_name, pak_key);
+
 	ZERO_STRUCT(packer);
 }
 
+#if PACK_SELF_TEST
+#define PACK_SELF_TEST_MAX_FILES 256
+#define PACK_SELF_TEST_ITERATIONS 4
+//NOTE: Every tail length up to past the widest SIMD step (8 pixels for AVX2, 16 bytes of RGB), and a one pixel start offset for misalignment!!
+#define PACK_SELF_TEST_MAX_TAIL 33
+
+enum PackKernelId {
+	PackKernelId_premultiply_alpha,
+	PackKernelId_expand_rgb_to_rgba,
+	PackKernelId_find_alpha_bounds,
+	PackKernelId_copy_pixel_rect,
+
+	PackKernelId_count,
+};
+
+char const * pack_kernel_names[PackKernelId_count] = {
+	"premultiply_alpha",
+	"expand_rgb_to_rgba",
+	"find_alpha_bounds",
+	"copy_pixel_rect",
+};
+
+//NOTE: The path each kernel's main loop takes in this build, keep in sync with the kernels!!
+char const * pack_kernel_paths[PackKernelId_count] = {
+#if PACK_AVX2
+	"AVX2",
+	"SSSE3 shuffle",
+#elif PACK_SSE2
+	"SSE2",
+	"SSE2 unpack",
+#else
+	"scalar",
+	"scalar",
+#endif
+#if PACK_SSE2
+	"SSE2",
+#else
+	"scalar",
+#endif
+	"memcpy",
+};
+
+struct PackKernelStats {
+	u32 mismatch_count;
+
+	f64 bytes;
+	f64 scalar_ms;
+	f64 simd_ms;
+};
+
+b32 check_kernel_output(PackKernelStats * stats, PackKernelId id, char const * file_name, u32 detail, b32 matches) {
+	if(!matches) {
+		if(!stats->mismatch_count) {
+			std::printf("ERROR: %s mismatch in %s (%u)!!\n", pack_kernel_names[id], file_name, detail);
+		}
+
+		stats->mismatch_count++;
+	}
+
+	return matches;
+}
+
+void self_test_premultiply_alpha(PackKernelStats * stats, char const * file_name, u8 * rgba, u32 pixel_count, u8 * scalar_buf, u8 * simd_buf) {
+	for(u32 tail = 0; tail <= PACK_SELF_TEST_MAX_TAIL && tail < pixel_count; tail++) {
+		u32 first = tail & 1;
+		u32 count = pixel_count - tail - first;
+
+		std::memcpy(scalar_buf, rgba + first * 4, count * 4);
+		std::memcpy(simd_buf, rgba + first * 4, count * 4);
+
+		premultiply_alpha_scalar(scalar_buf, count);
+		premultiply_alpha(simd_buf, count);
+
+		check_kernel_output(stats, PackKernelId_premultiply_alpha, file_name, count, std::memcmp(scalar_buf, simd_buf, count * 4) == 0);
+	}
+
+	for(u32 i = 0; i < PACK_SELF_TEST_ITERATIONS; i++) {
+		std::memcpy(scalar_buf, rgba, pixel_count * 4);
+		f64 start = get_time_ms();
+		premultiply_alpha_scalar(scalar_buf, pixel_count);
+		stats->scalar_ms += get_time_ms() - start;
+
+		std::memcpy(simd_buf, rgba, pixel_count * 4);
+		start = get_time_ms();
+		premultiply_alpha(simd_buf, pixel_count);
+		stats->simd_ms += get_time_ms() - start;
+
+		stats->bytes += pixel_count * 4;
+	}
+}
+
+void self_test_expand_rgb_to_rgba(PackKernelStats * stats, char const * file_name, u8 * rgb, u32 pixel_count, u8 * scalar_buf, u8 * simd_buf) {
+	for(u32 tail = 0; tail <= PACK_SELF_TEST_MAX_TAIL && tail < pixel_count; tail++) {
+		u32 first = tail & 1;
+		u32 count = pixel_count - tail - first;
+
+		expand_rgb_to_rgba_scalar(scalar_buf, rgb + first * 3, count);
+		expand_rgb_to_rgba(simd_buf, rgb + first * 3, count);
+
+		check_kernel_output(stats, PackKernelId_expand_rgb_to_rgba, file_name, count, std::memcmp(scalar_buf, simd_buf, count * 4) == 0);
+	}
+
+	for(u32 i = 0; i < PACK_SELF_TEST_ITERATIONS; i++) {
+		f64 start = get_time_ms();
+		expand_rgb_to_rgba_scalar(scalar_buf, rgb, pixel_count);
+		stats->scalar_ms += get_time_ms() - start;
+
+		start = get_time_ms();
+		expand_rgb_to_rgba(simd_buf, rgb, pixel_count);
+		stats->simd_ms += get_time_ms() - start;
+
+		stats->bytes += pixel_count * 3;
+	}
+}
+
+b32 pixel_bounds_equal(PixelBounds b0, PixelBounds b1) {
+	return b0.min_x == b1.min_x && b0.min_y == b1.min_y && b0.max_x == b1.max_x && b0.max_y == b1.max_y;
+}
+
+void self_test_find_alpha_bounds(PackKernelStats * stats, char const * file_name, u8 * rgba, u32 width, u32 height, u8 * crop_buf) {
+	//NOTE: Cropped to odd widths so the SIMD scan ends mid-row!!
+	for(u32 tail = 0; tail <= PACK_SELF_TEST_MAX_TAIL && tail < width; tail++) {
+		u32 first = tail & 1;
+		u32 crop_width = width - tail - first;
+
+		copy_pixel_rect_scalar(crop_buf, crop_width, 0, 0, rgba, width, first, 0, crop_width, height);
+
+		PixelBounds scalar_bounds = find_alpha_bounds_scalar(crop_buf, crop_width, height);
+		PixelBounds simd_bounds = find_alpha_bounds(crop_buf, crop_width, height);
+
+		check_kernel_output(stats, PackKernelId_find_alpha_bounds, file_name, crop_width, pixel_bounds_equal(scalar_bounds, simd_bounds));
+	}
+
+	for(u32 i = 0; i < PACK_SELF_TEST_ITERATIONS; i++) {
+		f64 start = get_time_ms();
+		PixelBounds scalar_bounds = find_alpha_bounds_scalar(rgba, width, height);
+		stats->scalar_ms += get_time_ms() - start;
+
+		start = get_time_ms();
+		PixelBounds simd_bounds = find_alpha_bounds(rgba, width, height);
+		stats->simd_ms += get_time_ms() - start;
+
+		check_kernel_output(stats, PackKernelId_find_alpha_bounds, file_name, width, pixel_bounds_equal(scalar_bounds, simd_bounds));
+		stats->bytes += width * height * 4;
+	}
+}
+
+void self_test_copy_pixel_rect(PackKernelStats * stats, char const * file_name, u8 * rgba, u32 width, u32 height, u8 * scalar_buf, u8 * simd_buf) {
+	for(u32 tail = 0; tail <= PACK_SELF_TEST_MAX_TAIL && tail < width && tail < height; tail++) {
+		u32 first = tail & 1;
+		u32 rect_width = width - tail - first;
+		u32 rect_height = height - tail - first;
+
+		//NOTE: Into the middle of a destination as wide as the source, like blitting into an atlas!!
+		std::memset(scalar_buf, 0, width * height * 4);
+		std::memset(simd_buf, 0, width * height * 4);
+
+		copy_pixel_rect_scalar(scalar_buf, width, tail - first, first, rgba, width, first, tail - first, rect_width, rect_height);
+		copy_pixel_rect(simd_buf, width, tail - first, first, rgba, width, first, tail - first, rect_width, rect_height);
+
+		check_kernel_output(stats, PackKernelId_copy_pixel_rect, file_name, rect_width, std::memcmp(scalar_buf, simd_buf, width * height * 4) == 0);
+	}
+
+	for(u32 i = 0; i < PACK_SELF_TEST_ITERATIONS; i++) {
+		f64 start = get_time_ms();
+		copy_pixel_rect_scalar(scalar_buf, width, 0, 0, rgba, width, 0, 0, width, height);
+		stats->scalar_ms += get_time_ms() - start;
+
+		start = get_time_ms();
+		copy_pixel_rect(simd_buf, width, 0, 0, rgba, width, 0, 0, width, height);
+		stats->simd_ms += get_time_ms() - start;
+
+		stats->bytes += width * height * 4;
+	}
+}
+
+//NOTE: Golden output is the scalar kernel, run from dat like the packer itself!!
+i32 run_pack_self_test() {
+#if PACK_AVX2
+	char const * simd_name = "AVX2";
+#elif PACK_SSE2
+	char const * simd_name = "SSE2";
+#else
+	char const * simd_name = "none";
+#endif
+	std::printf("Pixel kernel self test, SIMD: %s\n", simd_name);
+
+	char (* file_names)[256] = (char (*)[256])ALLOC_ARRAY(char, PACK_SELF_TEST_MAX_FILES * 256);
+	u32 file_count = find_files("*.png", file_names, PACK_SELF_TEST_MAX_FILES);
+
+	PackKernelStats stats[PackKernelId_count] = {};
+
+	u32 tested_count = 0;
+	for(u32 i = 0; i < file_count; i++) {
+		char const * file_name = file_names[i];
+
+		i32 width, height, channels;
+		u8 * rgba = stbi_load(file_name, &width, &height, &channels, 4);
+		u8 * rgb = stbi_load(file_name, &width, &height, &channels, 3);
+		if(!rgba || !rgb || width < 2 || height < 2) {
+			std::printf("WARNING: Skipping %s\n", file_name);
+		}
+		else {
+			u32 pixel_count = (u32)(width * height);
+			u8 * scalar_buf = ALLOC_ARRAY(u8, pixel_count * 4);
+			u8 * simd_buf = ALLOC_ARRAY(u8, pixel_count * 4);
+
+			self_test_premultiply_alpha(stats + PackKernelId_premultiply_alpha, file_name, rgba, pixel_count, scalar_buf, simd_buf);
+			self_test_expand_rgb_to_rgba(stats + PackKernelId_expand_rgb_to_rgba, file_name, rgb, pixel_count, scalar_buf, simd_buf);
+			self_test_find_alpha_bounds(stats + PackKernelId_find_alpha_bounds, file_name, rgba, (u32)width, (u32)height, scalar_buf);
+			self_test_copy_pixel_rect(stats + PackKernelId_copy_pixel_rect, file_name, rgba, (u32)width, (u32)height, scalar_buf, simd_buf);
+
+			FREE_MEMORY(scalar_buf);
+			FREE_MEMORY(simd_buf);
+
+			tested_count++;
+		}
+
+		stbi_image_free(rgba);
+		stbi_image_free(rgb);
+	}
+
+	u32 mismatch_count = 0;
+	for(u32 i = 0; i < PackKernelId_count; i++) {
+		PackKernelStats * it = stats + i;
+		mismatch_count += it->mismatch_count;
+
+		f64 megabytes = it->bytes / (1024.0 * 1024.0);
+		f64 scalar_rate = it->scalar_ms > 0.0 ? megabytes / (it->scalar_ms / 1000.0) : 0.0;
+		f64 simd_rate = it->simd_ms > 0.0 ? megabytes / (it->simd_ms / 1000.0) : 0.0;
+		std::printf("%-20s %-13s %s | scalar: %8.1f MB/s | simd: %8.1f MB/s | %.2fx\n", pack_kernel_names[i], pack_kernel_paths[i], it->mismatch_count ? "FAILED" : "ok", scalar_rate, simd_rate, scalar_rate > 0.0 ? simd_rate / scalar_rate : 0.0);
+	}
+
+	std::printf("%u images, %u mismatches\n", tested_count, mismatch_count);
+
+	FREE_MEMORY(file_names);
+	return mismatch_count || !tested_count ? 1 : 0;
+}
+#endif
+
 int main() {
+	//NOTE: This is global state in stb_image so set it once before any worker threads start!!
+	stbi_set_flip_vertically_on_load(true);
+
+#if PACK_SELF_TEST
+	return run_pack_self_test();
+#endif
+
+	make_directory(PACK_CACHE_DIR);
+	make_directory(PACK_OUTPUT_DIR);
+
 	AssetPacker * packer = ALLOC_STRUCT(AssetPacker);
 	ZERO_STRUCT(packer);
 
@@ -681,7 +2644,7 @@ int main() {
 		push_texture(packer, "white.png", AssetId_white);
 		push_texture(packer, "load_body.png", AssetId_load_background);
 
-		write_out_asset_pack(packer, "preload.pak");
+		write_out_asset_pack(packer, "preload.pak", true);
 	}
 
 	{
@@ -18,7 +18,8 @@ i16 audio_f32_to_i16(f32 sample) {
 
 AudioSource * play_audio_clip(AudioState * audio_state, AudioClip * clip, b32 loop = false, math::Vec2 volume = math::vec2(1.0f)) {
 	AudioSource * source = 0;
-	if(audio_state->supported && clip) {
+	//NOTE: Clips still being resampled aren't playable yet!!
+	if(audio_state->supported && clip && clip->ready) {
 		if(!audio_state->source_free_list) {
 			audio_state->source_free_list = PUSH_STRUCT(audio_state->arena, AudioSource);
 			audio_state->source_free_list->next = 0;
@@ -129,7 +130,6 @@ void audio_output_samples(AudioState * audio_state, i16 * sample_memory_ptr, u32
 	audio_state->debug_sources_to_free = 0;
 	audio_state->debug_sources_playing = 0;
 
-	f32 playback_rate = samples_per_second != AUDIO_SAMPLE_RATE ? (f32)AUDIO_SAMPLE_RATE / (f32)samples_per_second : 1.0f;
 	f32 seconds_per_sample = 1.0f / samples_per_second;
 
 	AudioSource ** source_ptr = &audio_state->sources;
@@ -137,8 +137,14 @@ void audio_output_samples(AudioState * audio_state, i16 * sample_memory_ptr, u32
 		AudioSource * source = *source_ptr;
 		AudioClip * clip = source->clip;
 
-		f32 pitch = source->pitch * playback_rate;
+		//NOTE: Clips are resampled to the device rate at load time, so this is normally just the source pitch!!
+		f32 pitch = source->pitch;
+		if(clip->samples_per_second != samples_per_second) {
+			pitch *= (f32)clip->samples_per_second / (f32)samples_per_second;
+		}
+
 		AudioVal64 pitch64 = audio_val64(pitch);
+		b32 unpitched = pitch64.int_part == 1 && pitch64.frc_part == 0.0f;
 
 		b32 free_source = false;
 		u32 samples_left_to_write = samples_to_write;
@@ -185,26 +191,57 @@ void audio_output_samples(AudioState * audio_state, i16 * sample_memory_ptr, u32
 				}
 
 				for(u32 i = 0; i < samples_to_play; i++) {
-					for(u32 ii = 0; ii < AUDIO_CHANNELS; ii++) {
-						u32 sample_index = source->sample_pos.int_part;
-						ASSERT(sample_index < valid_samples);
-
-						i16 sample_i16 = clip->sample_data[sample_index * 2 + ii];
-						f32 sample_f32 = audio_i16_to_f32(sample_i16);
+					u32 sample_index = source->sample_pos.int_part;
+					ASSERT(sample_index < valid_samples);
+
+					f32 samples_f32[AUDIO_CHANNELS];
+					if(unpitched && source->sample_pos.frc_part == 0.0f) {
+						//NOTE: Straight copy, nothing to interpolate!!
+						if(clip->channels == 1) {
+							f32 sample_f32 = audio_i16_to_f32(clip->sample_data[sample_index]);
+							for(u32 ii = 0; ii < AUDIO_CHANNELS; ii++) {
+								samples_f32[ii] = sample_f32;
+							}
+						}
+						else {
+							ASSERT(clip->channels == AUDIO_CHANNELS);
 
+							for(u32 ii = 0; ii < AUDIO_CHANNELS; ii++) {
+								samples_f32[ii] = audio_i16_to_f32(clip->sample_data[sample_index * AUDIO_CHANNELS + ii]);
+							}
+						}
+					}
+					else {
 						u32 next_sample_index = sample_index + 1;
 						ASSERT(next_sample_index < (valid_samples + AUDIO_PADDING_SAMPLES));
 
-						i16 next_sample_i16 = clip->sample_data[next_sample_index * 2 + ii];
-						f32 next_sample_f32 = audio_i16_to_f32(next_sample_i16);
+						if(clip->channels == 1) {
+							//NOTE: Mono clips are read once and panned by the per-channel volume!!
+							f32 sample_f32 = audio_i16_to_f32(clip->sample_data[sample_index]);
+							f32 next_sample_f32 = audio_i16_to_f32(clip->sample_data[next_sample_index]);
+							sample_f32 = math::lerp(sample_f32, next_sample_f32, source->sample_pos.frc_part);
 
-						sample_f32 = math::lerp(sample_f32, next_sample_f32, source->sample_pos.frc_part);
+							for(u32 ii = 0; ii < AUDIO_CHANNELS; ii++) {
+								samples_f32[ii] = sample_f32;
+							}
+						}
+						else {
+							ASSERT(clip->channels == AUDIO_CHANNELS);
 
-						u32 out_sample_index = samples_written * 2 + ii;
+							for(u32 ii = 0; ii < AUDIO_CHANNELS; ii++) {
+								f32 sample_f32 = audio_i16_to_f32(clip->sample_data[sample_index * AUDIO_CHANNELS + ii]);
+								f32 next_sample_f32 = audio_i16_to_f32(clip->sample_data[next_sample_index * AUDIO_CHANNELS + ii]);
+								samples_f32[ii] = math::lerp(sample_f32, next_sample_f32, source->sample_pos.frc_part);
+							}
+						}
+					}
+
+					for(u32 ii = 0; ii < AUDIO_CHANNELS; ii++) {
+						u32 out_sample_index = samples_written * AUDIO_CHANNELS + ii;
 						i16 out_sample_i16 = sample_memory_ptr[out_sample_index];
 						f32 out_sample_f32 = audio_i16_to_f32(out_sample_i16);
 
-						out_sample_f32 += sample_f32 * source->volume.v[ii] * audio_state->master_volume;
+						out_sample_f32 += samples_f32[ii] * source->volume.v[ii] * audio_state->master_volume;
 						out_sample_f32 = math::clamp(out_sample_f32, -1.0f, 1.0f);
 
 						sample_memory_ptr[out_sample_index] = audio_f32_to_i16(out_sample_f32);
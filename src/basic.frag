@@ -7,9 +7,16 @@ varying vec2 tex_coord;
 varying vec4 vert_color;
 
 uniform sampler2D tex0;
+uniform float sdf_edge;
 
 void main() {
-	gl_FragColor = texture2D(tex0, tex_coord) * vert_color;
+	vec4 texel = texture2D(tex0, tex_coord);
+	//NOTE: Distance field textures, sdf_edge is half the antialiasing band in distance units!!
+	if(sdf_edge > 0.0) {
+		texel = vec4(smoothstep(0.5 - sdf_edge, 0.5 + sdf_edge, texel.a));
+	}
+
+	gl_FragColor = texel * vert_color;
 }
 
 );
\ No newline at end of file
@@ -82,10 +82,11 @@ void change_entity_asset(Entity * entity, AssetState * assets, AssetRef asset) {
 	}
 }
 
-Entity * push_entity(EntityArray * entities, AssetState * assets, AssetRef asset, math::Vec3 pos = math::vec3(0.0f)) {
+Entity * push_entity(EntityArray * entities, AssetState * assets, EntityLayer layer, AssetRef asset, math::Vec3 pos = math::vec3(0.0f)) {
 	ASSERT(entities->count < ARRAY_COUNT(entities->elems));
 
 	Entity * entity = entities->elems + entities->count++;
+	entity->layer = layer;
 	entity->pos = pos;
 	entity->offset = math::vec2(0.0f);
 	entity->scale = math::vec2(1.0f);
@@ -595,6 +596,7 @@ UiElement * process_ui_layer(MetaStateHeader * meta_state, UiLayer * ui_layer, R
 }
 
 void push_ui_layer_to_render_group(UiLayer * ui_layer, RenderGroup * render_group) {
+	set_render_layer(render_group, UiRenderLayer_buttons);
 	for(u32 i = 0; i < ui_layer->elem_count; i++) {
 		UiElement * elem = ui_layer->elems + i;
 		push_textured_quad(render_group, elem->asset);
@@ -744,7 +746,8 @@ void init_main_meta_state(MetaStateHeader * meta_state) {
 	f32 scene_y_offset = (f32)screen_height / (1.0f / (scene_max_z + 1.0f));
 
 	for(u32 i = 0; i < ARRAY_COUNT(main_state->background); i++) {
-		Entity * entity = push_entity(entities, meta_state->assets, asset_ref(AssetId_background, i));
+		//NOTE: The second background fades in over the first!!
+		Entity * entity = push_entity(entities, meta_state->assets, i ? EntityLayer_background_fade : EntityLayer_background, asset_ref(AssetId_background, i));
 
 		f32 z = scene_max_z;
 
@@ -772,15 +775,17 @@ void init_main_meta_state(MetaStateHeader * meta_state) {
 		math::Vec2 align = math::rec_pos(get_asset_bounds(meta_state->assets, asset.id, asset.index));
 		math::Vec3 pos = unproject_pos(align, scene_max_z);
 
-		main_state->sun = push_entity(entities, meta_state->assets, asset, pos);
+		main_state->sun = push_entity(entities, meta_state->assets, EntityLayer_sun, asset, pos);
 	}
 
 	for(u32 i = 0; i < SceneId_count; i++) {
 		Scene * scene = main_state->scenes + i;
 		scene->y = scene_y_offset * i;
 
-		for(u32 layer_index = 0; layer_index < ARRAY_COUNT(scene->layers) - 1; layer_index++) {
-			Entity * entity = push_entity(entities, meta_state->assets, asset_ref(scene->asset_id, layer_index));
+		for(u32 layer_index = 0; layer_index < ARRAY_COUNT(scene->layers); layer_index++) {
+			//NOTE: The foreground is at the same z as the player, so it needs a layer on top!!
+			EntityLayer entity_layer = layer_index < ARRAY_COUNT(scene->layers) - 1 ? EntityLayer_scene : EntityLayer_foreground;
+			Entity * entity = push_entity(entities, meta_state->assets, entity_layer, asset_ref(scene->asset_id, layer_index));
 
 			f32 z = layer_z_offsets[layer_index];
 
@@ -810,7 +815,7 @@ void init_main_meta_state(MetaStateHeader * meta_state) {
 	player->clone_offset = math::vec2(-3.75f, 0.0f);
 
 	for(i32 i = ARRAY_COUNT(player->clones) - 1; i >= 0; i--) {
-		Entity * entity = push_entity(entities, assets, asset_ref(AssetId_clone));
+		Entity * entity = push_entity(entities, assets, EntityLayer_clones, asset_ref(AssetId_clone));
 		entity->scale = math::vec2(0.75f);
 		entity->color = get_rand_clone_color();
 		entity->color.a = 0.0f;
@@ -821,7 +826,7 @@ void init_main_meta_state(MetaStateHeader * meta_state) {
 	}
 
 	player->initial_pos = math::vec3((f32)screen_width * -0.25f, main_state->height_above_ground, 0.0f);
-	player->e = push_entity(entities, assets, asset_ref(AssetId_dolly_idle), player->initial_pos);
+	player->e = push_entity(entities, assets, EntityLayer_player, asset_ref(AssetId_dolly_idle), player->initial_pos);
 	player->e->speed = math::vec2(562.5f, 3000.0f);
 	player->e->damp = 0.1f;
 	player->allow_input = true;
@@ -829,33 +834,33 @@ void init_main_meta_state(MetaStateHeader * meta_state) {
 	player->shield_radius = 0.0f;
 	player->has_shield = false;
 	for(u32 i = 0; i < ARRAY_COUNT(player->shield_clones); i++) {
-		Entity * entity = push_entity(entities, assets, asset_ref(AssetId_clone));
+		Entity * entity = push_entity(entities, assets, EntityLayer_shield_clones, asset_ref(AssetId_clone));
 		entity->scale = math::vec2(0.75f);
 		entity->color = get_rand_clone_color();
 
 		player->shield_clones[i] = entity;
 	}
-	player->shield = push_entity(entities, assets, asset_ref(AssetId_shield));
+	player->shield = push_entity(entities, assets, EntityLayer_shield, asset_ref(AssetId_shield));
 	player->shield->color.a = 0.0f;
 
 	EntityEmitter * emitter = &main_state->entity_emitter;
 	emitter->pos = math::vec3(screen_width * 0.75f, main_state->height_above_ground, 0.0f);
-	emitter->glow = push_entity(entities, assets, asset_ref(AssetId_glow));
+	emitter->glow = push_entity(entities, assets, EntityLayer_glow, asset_ref(AssetId_glow));
 	emitter->glow->color.a = 0.0f;
 	emitter->glow->scale = math::vec2(4.0f);
 	for(u32 i = 0; i < ARRAY_COUNT(emitter->entity_array); i++) {
-		emitter->entity_array[i] = push_entity(entities, assets, asset_ref(ASSET_FIRST_GROUP_ID(collect)), emitter->pos);
+		emitter->entity_array[i] = push_entity(entities, assets, EntityLayer_pickups, asset_ref(ASSET_FIRST_GROUP_ID(collect)), emitter->pos);
 	}
 
 	RocketSequence * seq = &main_state->rocket_seq;
-	seq->rocket = push_entity(entities, assets, asset_ref(AssetId_rocket_large));
+	seq->rocket = push_entity(entities, assets, EntityLayer_rocket, asset_ref(AssetId_rocket_large));
 	seq->rocket->collider = math::rec_offset(seq->rocket->collider, math::vec2(0.0f, -math::rec_dim(seq->rocket->collider).y * 0.35f));
 	seq->rocket->color.a = 0.0f;
 	seq->playing = false;
 	seq->time_ = 0.0f;
 
 	Concord * concord = &main_state->concord;
-	concord->e = push_entity(entities, assets, asset_ref(AssetId_concord), math::vec3(screen_width * 4.0f, main_state->height_above_ground, 0.0f));
+	concord->e = push_entity(entities, assets, EntityLayer_concord, asset_ref(AssetId_concord), math::vec3(screen_width * 4.0f, main_state->height_above_ground, 0.0f));
 
 	f32 cloud_y_offsets[ARRAY_COUNT(main_state->clouds)] = {
 		-165.0f,
@@ -864,31 +869,11 @@ void init_main_meta_state(MetaStateHeader * meta_state) {
 	};
 
 	for(u32 i = 0; i < ARRAY_COUNT(main_state->clouds); i++) {
-		Entity * entity = push_entity(entities, meta_state->assets, asset_ref(AssetId_clouds), math::vec3(0.0f, cloud_y_offsets[i], 0.0f));
+		Entity * entity = push_entity(entities, meta_state->assets, EntityLayer_clouds, asset_ref(AssetId_clouds), math::vec3(0.0f, cloud_y_offsets[i], 0.0f));
 		entity->scrollable = true;
 		main_state->clouds[i] = entity;
 	}
 
-	//TODO: Adding foreground layer at the end until we have sorting!!
-	for(u32 i = 0; i < SceneId_count; i++) {
-		Scene * scene = main_state->scenes + i;
-
-		u32 layer_index = ARRAY_COUNT(scene->layers) - 1;
-
-		Entity * entity = push_entity(entities, assets, asset_ref(scene->asset_id, layer_index));
-
-		f32 z = layer_z_offsets[layer_index];
-
-		math::Vec2 dim = math::rec_dim(get_entity_render_bounds(meta_state->assets, entity));
-		f32 y_offset = ((dim.y - (f32)screen_height) * 0.5f) * (z + 1.0f);
-
-		entity->pos.y = scene->y + y_offset;
-		entity->pos.z = z;
-		entity->scrollable = true;
-
-		scene->layers[layer_index] = entity;
-	}
-
 	ScoreSystem * score_system = &main_state->score_system;
 	push_ui_elem(&score_system->ui, ScoreButtonId_back, AssetId_btn_back, AssetId_click_no);
 	push_ui_elem(&score_system->ui, ScoreButtonId_replay, AssetId_btn_replay, AssetId_click_yes);
@@ -957,13 +942,16 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 
 		game_state->arena = memory_arena((u8 *)game_memory->ptr + sizeof(GameState), game_memory->size - sizeof(GameState));
 
-		load_assets(&game_state->assets, &game_state->arena);
+		load_assets(&game_state->assets, &game_state->arena, game_input->audio_samples_per_second);
 		load_audio(&game_state->audio_state, &game_state->arena, &game_state->assets, game_input->audio_supported);
 		load_render(&game_state->render_state, &game_state->arena, &game_state->assets, game_input->back_buffer_width, game_input->back_buffer_height);
 
 		game_state->loading_render_group = allocate_render_group(&game_state->render_state, &game_state->arena, game_state->render_state.screen_width, game_state->render_state.screen_height, 32);
 	}
 
+	process_texture_uploads(&game_state->assets);
+	process_audio_resamples(&game_state->assets);
+
 	if(!game_state->loaded) {
 		AssetState * assets = &game_state->assets;
 		RenderState * render_state = &game_state->render_state;
@@ -980,8 +968,10 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 
 		f32 total_width = 420.0f;
 		math::Vec2 dim = math::vec2(total_width * load_progress, 48.0f);
+		set_render_layer(render_group, UiRenderLayer_background);
 		push_colored_quad(render_group, math::vec3((-total_width + dim.x) * 0.5f, 0.0f, 0.0f), dim, 0.0f, math::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 
+		set_render_layer(render_group, UiRenderLayer_content);
 		push_textured_quad(render_group, asset_ref(AssetId_load_background));
 
 		render_and_clear_render_group(render_state, render_group);
@@ -1532,7 +1522,7 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 							fire_audio_clip(audio_state, clip, math::vec2(1.0f), pitch);
 						}
 
-						//TODO: Allocate these separately (or bring closer when we have sorting) for more efficient batching!!
+						//NOTE: Pickups sort by atlas within their layer, so swapping to the circle doesn't break up the batches!!
 						if(!ASSET_IN_GROUP(atom_smasher, entity->asset.id)) {
 							change_entity_asset(entity, assets, asset_ref(AssetId_circle));
 							entity->anim_time = 0.0f;
@@ -1582,62 +1572,63 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 
 						f32 x_offset = -(read_cursor_frac + (reads_ahead - 1)) * tile_size_pixels;
 
-						Tiles * tiles = map->tiles + read_pos;
-						for(u32 y = 0; y < TILE_MAP_HEIGHT; y++) {
-							u32 tile_id = tiles->ids[y];
-							if(tile_id != TileId_null) {
-								if(emitter->entity_count < ARRAY_COUNT(emitter->entity_array)) {
-									Entity * entity = emitter->entity_array[emitter->entity_count++];
-
-									entity->pos = emitter->pos;
-									entity->pos.x += x_offset;
-									entity->pos.y += (((f32)y + 0.5f) / (f32)TILE_MAP_HEIGHT) * projection_dim.y - projection_dim.y * 0.5f;
-									entity->scale = math::vec2(1.0f);
-
-									entity->color = math::vec4(1.0f);
-									if(tile_id == TileId_clone) {
-										entity->color = get_rand_clone_color();
-									}
+						//NOTE: Only the tiles that actually spawn something are stored!!
+						for(u32 spawn_index = map->column_offsets[read_pos]; spawn_index < map->column_offsets[read_pos + 1]; spawn_index++) {
+							TileSpawn const * spawn = map->spawns + spawn_index;
+							u32 tile_id = spawn->id;
+							u32 y = spawn->row;
 
-									entity->anim_time = 0.0f;
+							if(emitter->entity_count < ARRAY_COUNT(emitter->entity_array)) {
+								Entity * entity = emitter->entity_array[emitter->entity_count++];
 
-									AssetId asset_id = current_scene->tile_to_asset_table[tile_id];
-									if(tile_id == TileId_collect) {
-										u32 item_count = 0;
-										AssetId item_pool[ASSET_GROUP_COUNT(collect)];
-										for(u32 i = 0; i < ASSET_GROUP_COUNT(collect); i++) {
-											if(!main_state->item_removed_from_pool[i]) {
-												item_pool[item_count++] = ASSET_GROUP_INDEX_TO_ID(collect, i);
-											}
-										}
+								entity->pos = emitter->pos;
+								entity->pos.x += x_offset;
+								entity->pos.y += (((f32)y + 0.5f) / (f32)TILE_MAP_HEIGHT) * projection_dim.y - projection_dim.y * 0.5f;
+								entity->scale = math::vec2(1.0f);
+
+								entity->color = math::vec4(1.0f);
+								if(tile_id == TileId_clone) {
+									entity->color = get_rand_clone_color();
+								}
 
-										ASSERT(item_count);
-										if(item_count) {
-											asset_id = item_pool[math::rand_u32() % item_count];
+								entity->anim_time = 0.0f;
+
+								AssetId asset_id = current_scene->tile_to_asset_table[tile_id];
+								if(tile_id == TileId_collect) {
+									u32 item_count = 0;
+									AssetId item_pool[ASSET_GROUP_COUNT(collect)];
+									for(u32 i = 0; i < ASSET_GROUP_COUNT(collect); i++) {
+										if(!main_state->item_removed_from_pool[i]) {
+											item_pool[item_count++] = ASSET_GROUP_INDEX_TO_ID(collect, i);
 										}
+									}
 
-										emitter->glow->pos = entity->pos;
-										emitter->glow->color.a = 1.0f;
+									ASSERT(item_count);
+									if(item_count) {
+										asset_id = item_pool[math::rand_u32() % item_count];
 									}
 
-									change_entity_asset(entity, assets, asset_ref(asset_id));
-									if(ASSET_IN_GROUP(atom_smasher, entity->asset.id)) {
-										f32 width = 48.0f;
-										f32 height = (ASSET_ID_TO_GROUP_INDEX(atom_smasher, entity->asset.id) + 1) * width;
-										math::Vec2 dim = math::vec2(width, height) - 16.0f;
+									emitter->glow->pos = entity->pos;
+									emitter->glow->color.a = 1.0f;
+								}
+
+								change_entity_asset(entity, assets, asset_ref(asset_id));
+								if(ASSET_IN_GROUP(atom_smasher, entity->asset.id)) {
+									f32 width = 48.0f;
+									f32 height = (ASSET_ID_TO_GROUP_INDEX(atom_smasher, entity->asset.id) + 1) * width;
+									math::Vec2 dim = math::vec2(width, height) - 16.0f;
 
-										entity->collider = math::rec2_pos_dim(math::vec2(0.0f), dim);
-									}
+									entity->collider = math::rec2_pos_dim(math::vec2(0.0f), dim);
+								}
 
-									entity->hit = false;
+								entity->hit = false;
 
-									if(tile_id == TileId_rocket) {
-										emitter->rocket_map_id = current_scene->map_id;
-										emitter->rocket_map_index = current_scene->map_index;
-										emitter->rocket_map_count = current_scene->map_count;
+								if(tile_id == TileId_rocket) {
+									emitter->rocket_map_id = current_scene->map_id;
+									emitter->rocket_map_index = current_scene->map_index;
+									emitter->rocket_map_count = current_scene->map_count;
 
-										entity->collider = math::rec_scale(get_asset_bounds(assets, entity->asset.id, entity->asset.index), math::vec2(0.75f, 1.0f));
-									}
+									entity->collider = math::rec_scale(get_asset_bounds(assets, entity->asset.id, entity->asset.index), math::vec2(0.75f, 1.0f));
 								}
 							}
 						}
@@ -1758,6 +1749,7 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 			}
 		}
 
+		update_render_scale(render_state, game_input->delta_time);
 		begin_render(render_state);
 
 		switch(game_state->meta_state) {
@@ -1793,12 +1785,15 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 					math::Vec2 scale = math::vec2(frame->scale);
 
 					if(intro_state->current_frame_index == 4) {
+						set_render_layer(render_group, UiRenderLayer_background);
 						push_textured_quad(render_group, asset_ref(AssetId_intro4_background, 0), pos, scale);
 					}
 
+					set_render_layer(render_group, UiRenderLayer_content);
 					push_textured_quad(render_group, frame->asset, pos, scale);
 
 					if(intro_state->current_frame_index == 4) {
+						set_render_layer(render_group, UiRenderLayer_overlay);
 						push_textured_quad(render_group, asset_ref(AssetId_intro4_background, 1), pos, scale);
 					}
 				}
@@ -1810,6 +1805,7 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 				f32 align_x = ((f32)render_group->transform.projection_width - str_width) * 0.5f;
 
 				FontLayout font_layout = create_font_layout(font, math::vec2(render_group->transform.projection_width, render_group->transform.projection_height), font_scale, FontLayoutAnchor_bottom_left, math::vec2(align_x, 130.0f));
+				set_render_layer(render_group, UiRenderLayer_overlay_text);
 				push_c_str_to_render_group(render_group, font, &font_layout, frame->str, math::vec4(1.0f, 0.8f, 0.0f, 1.0f));
 
 				push_ui_layer_to_render_group(&intro_state->ui_layer, render_group);
@@ -1827,6 +1823,14 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 				EntityArray * entities = &main_state->entities;
 				for(u32 i = 0; i < entities->count; i++) {
 					Entity * entity = entities->elems + i;
+
+					//NOTE: Most of the clone and emitter pools are idle at any time, skip them before any asset lookups or projection!!
+					if(entity->hidden || entity->color.a <= 0.0f) {
+						main_state->render_group->debug_culled_count++;
+						continue;
+					}
+
+					set_render_layer(main_state->render_group, entity->layer);
 					push_textured_quad(main_state->render_group, entity->asset, entity->pos + math::vec3(entity->offset, 0.0f), entity->scale, entity->angle, entity->color, entity->scrollable);
 				}
 
@@ -1836,6 +1840,7 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 					RenderBatch * render_batch = render_state->render_batch;
 					render_batch->tex = get_texture_asset(render_state->assets, AssetId_white, 0);
 					render_batch->mode = RenderMode_lines;
+					render_batch->instanced = false;
 
 					RenderTransform * render_transform = &main_state->render_group->transform;
 					math::Mat3 projection = {
@@ -1851,8 +1856,8 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 						math::Vec2 pos = project_pos(render_transform, entity->pos + math::vec3(math::rec_pos(bounds) + entity->offset, 0.0f));
 						bounds = math::rec2_pos_dim(pos, math::rec_dim(bounds));
 
-						u32 elems_remaining = render_batch->v_len - render_batch->e;
-						if(elems_remaining < QUAD_LINES_ELEM_COUNT) {
+						u32 verts_remaining = render_batch->v_len - render_batch->e;
+						if(verts_remaining < QUAD_LINES_VERT_COUNT) {
 							render_and_clear_render_batch(render_batch, &render_state->basic_shader, &projection);
 						}
 
@@ -1867,6 +1872,7 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 
 				f32 letterbox_pixels = (projection_dim.y - main_state->letterboxed_height) * 0.5f;
 				if(letterbox_pixels > 0.0f) {
+					set_render_layer(ui_render_group, UiRenderLayer_background);
 					push_colored_quad(ui_render_group, math::vec3(0.0f, projection_dim.y - letterbox_pixels, 0.0f), projection_dim, 0.0f, math::vec4(0.0f, 0.0f, 0.0f, 1.0f));
 					push_colored_quad(ui_render_group, math::vec3(0.0f,-projection_dim.y + letterbox_pixels, 0.0f), projection_dim, 0.0f, math::vec4(0.0f, 0.0f, 0.0f, 1.0f));
 				}
@@ -1884,16 +1890,19 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 
 					{
 						FontLayout font_layout = create_font_layout(font, projection_dim, 1.0f, FontLayoutAnchor_bottom_centre, math::vec2(0.0f, fixed_letterboxing - 39.0f));
+						set_render_layer(ui_render_group, UiRenderLayer_text);
 						push_c_str_to_render_group(ui_render_group, font, &font_layout, main_state->scenes[main_state->current_scene].name);
 					}
 
 					{
+						set_render_layer(ui_render_group, UiRenderLayer_content);
 						push_textured_quad(ui_render_group, asset_ref(AssetId_label_clone), math::vec3(-32.0f, (projection_dim.y * 0.5f + 30.0f) - fixed_letterboxing, 0.0f), math::vec2(main_state->label_clone_scale));
 
 						str_clear(&temp_str);
 						str_print(&temp_str, "%u", score_system->clones);
 
 						FontLayout font_layout = create_font_layout(font, projection_dim, 1.0f, FontLayoutAnchor_top_left, math::vec2(projection_dim.x * 0.5f, 51.0f - fixed_letterboxing));
+						set_render_layer(ui_render_group, UiRenderLayer_text);
 						push_str_to_render_group(ui_render_group, font, &font_layout, &temp_str);
 					}
 
@@ -1929,13 +1938,16 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 					}
 
 					//TODO: Bake the offset into the texture!!
+					set_render_layer(ui_render_group, UiRenderLayer_content);
 					push_textured_quad(ui_render_group, main_state->arrow_buttons[0].asset, math::vec3(0.0f, 30.0f, 0.0f));
 					push_textured_quad(ui_render_group, main_state->arrow_buttons[1].asset, math::vec3(0.0f,-30.0f, 0.0f));
 				}
 
+				set_render_layer(ui_render_group, UiRenderLayer_overlay);
 				push_textured_quad(ui_render_group, asset_ref(AssetId_score_background), math::vec3(0.0f), math::vec2(1.0f), 0.0f, math::vec4(1.0f, 1.0f, 1.0f, score_system->alpha));
 
 				if(score_system->show) {
+					set_render_layer(ui_render_group, UiRenderLayer_overlay_content);
 					push_textured_quad(ui_render_group, asset_ref(AssetId_score_clone), math::vec3(0.0f, projection_dim.y * 0.5f - 120.0f, 0.0f));
 
 					f32 score_time_marker = 1.0f;
@@ -1960,6 +1972,7 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 
 						Font * font_large = get_font_asset(main_state->header.assets, AssetId_munro_large, 0);
 						FontLayout font_layout = create_font_layout(font_large, projection_dim, 1.0f, FontLayoutAnchor_top_centre, math::vec2(0.0f, -155.0f));
+						set_render_layer(ui_render_group, UiRenderLayer_overlay_text);
 						push_str_to_render_group(ui_render_group, font_large, &font_layout, &temp_str, math::vec4(1.0f, 0.8f, 0.0f, 1.0f));
 					}
 
@@ -1967,6 +1980,7 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 						f32 time_ = new_time - grats_time_marker;
 
 						FontLayout font_layout = create_font_layout(font, projection_dim, 1.0f, FontLayoutAnchor_top_centre, math::vec2(0.0f, -225.0f));
+						set_render_layer(ui_render_group, UiRenderLayer_overlay_text);
 						push_c_str_to_render_group(ui_render_group, font, &font_layout, "Well done, Dolly!", math::vec4(1.0f, 0.8f, 0.0f, 1.0f));
 					}
 
@@ -1987,6 +2001,7 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 						for(u32 i = 0; i < ARRAY_COUNT(main_state->item_found); i++) {
 							if(main_state->item_found[i]) {
 								AssetId asset_id = ASSET_GROUP_INDEX_TO_ID(score, i);
+								set_render_layer(ui_render_group, UiRenderLayer_overlay_content);
 								push_textured_quad(ui_render_group, asset_ref(asset_id));
 
 								item_count--;
@@ -2021,8 +2036,10 @@ void game_tick(GameMemory * game_memory, GameInput * game_input) {
 
 			char temp_buf[256];
 			Str temp_str = str_fixed_size(temp_buf, ARRAY_COUNT(temp_buf));
-			str_print(&temp_str, "dt: %fms\n", game_input->delta_time);
-			str_print(&temp_str, "asset load time: %fms | asset total size: %ukb\n", assets->debug_load_time, assets->debug_total_size / 1024);
+			str_print(&temp_str, "dt: %fms | draw calls: %u | gl state calls: %u made, %u skipped\n", game_input->delta_time, render_state->debug_draw_call_count, render_state->debug_gl_calls_made, render_state->debug_gl_calls_skipped);
+			str_print(&temp_str, "vertex upload: %u bytes | elements drawn: %u, culled: %u\n", render_state->debug_bytes_uploaded, render_state->debug_drawn_count, render_state->debug_culled_count);
+			str_print(&temp_str, "post filter: %s | fill saved: %u pixels | render scale: %f (%ux%u)\n", render_state->post_filter ? "on" : "skipped", render_state->debug_post_filter_pixels_saved, render_state->render_scale, render_state->render_width, render_state->render_height);
+			str_print(&temp_str, "preload time: %fms | asset load time: %fms | asset total size: %ukb\n", assets->debug_preload_time, assets->debug_load_time, assets->debug_total_size / 1024);
 			str_print(&temp_str, "supported: %s | sources playing: %u | sources to free: %u\n", game_state->audio_state.supported ? "true" : "false", game_state->audio_state.debug_sources_playing, game_state->audio_state.debug_sources_to_free);
 			str_print(&temp_str, "\n");
 			push_str_to_render_group(debug_render_group, debug_font, &debug_font_layout, &temp_str);
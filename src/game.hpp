@@ -11,6 +11,34 @@
 #define ANIMATION_FRAMES_PER_SEC 30
 #define PARALLAX_LAYER_COUNT 4
 
+//NOTE: Render layers, anything in the same layer (and z) can be reordered to merge batches so overlaps that matter need their own layer!!
+enum EntityLayer {
+	EntityLayer_background,
+	EntityLayer_background_fade,
+	EntityLayer_sun,
+	EntityLayer_scene,
+	EntityLayer_clones,
+	EntityLayer_player,
+	EntityLayer_shield_clones,
+	EntityLayer_shield,
+	EntityLayer_glow,
+	EntityLayer_pickups,
+	EntityLayer_rocket,
+	EntityLayer_concord,
+	EntityLayer_clouds,
+	EntityLayer_foreground,
+};
+
+enum UiRenderLayer {
+	UiRenderLayer_background,
+	UiRenderLayer_content,
+	UiRenderLayer_text,
+	UiRenderLayer_overlay,
+	UiRenderLayer_overlay_content,
+	UiRenderLayer_overlay_text,
+	UiRenderLayer_buttons,
+};
+
 struct UiElement {
 	u32 id;
 
@@ -34,6 +62,7 @@ struct Entity {
 	math::Vec4 color;
 	f32 angle;
 	b32 scrollable;
+	EntityLayer layer;
 
 	AssetRef asset;
 
@@ -331,6 +360,7 @@ struct GameInput {
 	u32 back_buffer_height;
 
 	b32 audio_supported;
+	u32 audio_samples_per_second;
 
 	f32 delta_time;
 	f32 total_time;
@@ -6,14 +6,24 @@
 
 #define GL_MAX_INFO_LOG_LENGTH 1024
 
+#define GL_MAX_CACHED_TEXTURE_UNITS 8
+#define GL_MAX_CACHED_VERTEX_ATTRIBS 8
+#define GL_MAX_CACHED_UNIFORMS 32
+
 namespace gl {
 	struct VertexBuffer {
 		GLuint id;
 		u32 vert_count;
+		//NOTE: In bytes!!
 		u32 vert_size;
 		u32 size_in_bytes;
 	};
 
+	struct IndexBuffer {
+		GLuint id;
+		u32 index_count;
+	};
+
 	struct Texture {
 		GLuint id;
 		u32 width;
@@ -28,6 +38,49 @@ namespace gl {
 		u32 height;
 	};
 
+	struct VertexAttribState {
+		b32 enabled;
+
+		GLuint buffer;
+		GLint size;
+		GLenum type;
+		GLboolean normalized;
+		GLsizei stride;
+		void const * offset;
+		GLuint divisor;
+	};
+
+	struct UniformState {
+		GLuint program;
+		GLint location;
+		u32 count;
+		f32 v[9];
+	};
+
+	//NOTE: Shadow copy of the GL state the renderer touches, only state changed through here is tracked!!
+	struct StateCache {
+		GLuint program;
+		GLuint frame_buffer;
+		GLuint array_buffer;
+		GLuint element_array_buffer;
+		GLint unpack_alignment;
+
+		GLenum active_texture;
+		GLuint textures[GL_MAX_CACHED_TEXTURE_UNITS];
+
+		VertexAttribState vertex_attribs[GL_MAX_CACHED_VERTEX_ATTRIBS];
+
+		u32 uniform_count;
+		UniformState uniforms[GL_MAX_CACHED_UNIFORMS];
+
+		u32 debug_calls_made;
+		u32 debug_calls_skipped;
+	};
+
+	static StateCache global_state_cache = {
+		0, 0, 0, 0, 4, GL_TEXTURE0,
+	};
+
 #define GL_CHECK_ERRORS() { GLenum err = glGetError(); while(err != GL_NO_ERROR) { std::printf("ERROR: %s:%u: %s\n", (char *)__FILE__, __LINE__, gl::error_to_str(err)); err = glGetError(); } }
 	char * error_to_str(GLenum err) {
 		char const * str = "";
@@ -69,6 +122,231 @@ namespace gl {
 		return (char *)str;
 	}
 
+	inline b32 state_changed(b32 changed) {
+		if(changed) {
+			global_state_cache.debug_calls_made++;
+		}
+		else {
+			global_state_cache.debug_calls_skipped++;
+		}
+
+		return changed;
+	}
+
+	void use_program(GLuint program) {
+		if(state_changed(global_state_cache.program != program)) {
+			glUseProgram(program);
+			global_state_cache.program = program;
+		}
+	}
+
+	void bind_frame_buffer(GLuint frame_buffer) {
+		if(state_changed(global_state_cache.frame_buffer != frame_buffer)) {
+			glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
+			global_state_cache.frame_buffer = frame_buffer;
+		}
+	}
+
+	void bind_array_buffer(GLuint buffer) {
+		if(state_changed(global_state_cache.array_buffer != buffer)) {
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			global_state_cache.array_buffer = buffer;
+		}
+	}
+
+	void bind_element_array_buffer(GLuint buffer) {
+		if(state_changed(global_state_cache.element_array_buffer != buffer)) {
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+			global_state_cache.element_array_buffer = buffer;
+		}
+	}
+
+	void set_unpack_alignment(GLint alignment) {
+		if(state_changed(global_state_cache.unpack_alignment != alignment)) {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+			global_state_cache.unpack_alignment = alignment;
+		}
+	}
+
+	void active_texture(GLenum unit) {
+		ASSERT(unit >= GL_TEXTURE0 && unit < GL_TEXTURE0 + GL_MAX_CACHED_TEXTURE_UNITS);
+
+		if(state_changed(global_state_cache.active_texture != unit)) {
+			glActiveTexture(unit);
+			global_state_cache.active_texture = unit;
+		}
+	}
+
+	//NOTE: Binds to the active unit, only GL_TEXTURE_2D is tracked!!
+	void bind_texture(GLuint texture) {
+		GLuint * bound = global_state_cache.textures + (global_state_cache.active_texture - GL_TEXTURE0);
+		if(state_changed(*bound != texture)) {
+			glBindTexture(GL_TEXTURE_2D, texture);
+			*bound = texture;
+		}
+	}
+
+	//NOTE: Enables exactly the attribs in the mask, anything a previous program left enabled gets disabled!!
+	void enable_vertex_attrib_arrays(u32 mask) {
+		ASSERT(!(mask >> GL_MAX_CACHED_VERTEX_ATTRIBS));
+
+		for(u32 i = 0; i < GL_MAX_CACHED_VERTEX_ATTRIBS; i++) {
+			VertexAttribState * attrib = global_state_cache.vertex_attribs + i;
+
+			b32 enabled = (mask >> i) & 1;
+			if(state_changed(attrib->enabled != enabled)) {
+				if(enabled) {
+					glEnableVertexAttribArray(i);
+				}
+				else {
+					glDisableVertexAttribArray(i);
+				}
+
+				attrib->enabled = enabled;
+			}
+		}
+	}
+
+	//NOTE: The attrib reads from whatever array buffer is bound, so that's part of the state too!!
+	void vertex_attrib_pointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, void const * offset) {
+		ASSERT(index < GL_MAX_CACHED_VERTEX_ATTRIBS);
+
+		VertexAttribState * attrib = global_state_cache.vertex_attribs + index;
+		b32 changed = attrib->buffer != global_state_cache.array_buffer || attrib->size != size || attrib->type != type || attrib->normalized != normalized || attrib->stride != stride || attrib->offset != offset;
+		if(state_changed(changed)) {
+			glVertexAttribPointer(index, size, type, normalized, stride, offset);
+
+			attrib->buffer = global_state_cache.array_buffer;
+			attrib->size = size;
+			attrib->type = type;
+			attrib->normalized = normalized;
+			attrib->stride = stride;
+			attrib->offset = offset;
+		}
+	}
+
+	//NOTE: Divisors are only ever non-zero once instancing is known to be supported, so the cache keeps this safe to call regardless!!
+	void vertex_attrib_divisor(GLuint index, GLuint divisor) {
+		ASSERT(index < GL_MAX_CACHED_VERTEX_ATTRIBS);
+
+		VertexAttribState * attrib = global_state_cache.vertex_attribs + index;
+		if(state_changed(attrib->divisor != divisor)) {
+#ifdef __EMSCRIPTEN__
+			glVertexAttribDivisorANGLE(index, divisor);
+#else
+			glVertexAttribDivisor(index, divisor);
+#endif
+			attrib->divisor = divisor;
+		}
+	}
+
+	void draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, void const * offset, GLsizei instance_count) {
+#ifdef __EMSCRIPTEN__
+		glDrawElementsInstancedANGLE(mode, count, type, offset, instance_count);
+#else
+		glDrawElementsInstanced(mode, count, type, offset, instance_count);
+#endif
+	}
+
+	b32 has_extension(char const * name) {
+		char const * extensions = (char const *)glGetString(GL_EXTENSIONS);
+
+		b32 found = false;
+		for(char const * it = extensions; it && *it && !found; it++) {
+			u32 i = 0;
+			while(name[i] && it[i] == name[i]) {
+				i++;
+			}
+
+			found = !name[i];
+		}
+
+		return found;
+	}
+
+	b32 instancing_supported() {
+#ifdef __EMSCRIPTEN__
+		//NOTE: WebGL 1 only has instancing through ANGLE_instanced_arrays, Emscripten reports it with a GL_ prefix!!
+		return has_extension("ANGLE_instanced_arrays");
+#else
+		//NOTE: Core since GL 3.3!!
+		return true;
+#endif
+	}
+
+	//NOTE: Uniforms belong to the current program, returns true if the value needs uploading!!
+	b32 update_uniform_state(GLint location, f32 const * v, u32 count) {
+		ASSERT(count <= ARRAY_COUNT(global_state_cache.uniforms[0].v));
+
+		UniformState * uniform = 0;
+		for(u32 i = 0; i < global_state_cache.uniform_count; i++) {
+			UniformState * it = global_state_cache.uniforms + i;
+			if(it->program == global_state_cache.program && it->location == location) {
+				uniform = it;
+				break;
+			}
+		}
+
+		b32 changed = true;
+		if(uniform && uniform->count == count) {
+			changed = false;
+			for(u32 i = 0; i < count; i++) {
+				if(uniform->v[i] != v[i]) {
+					changed = true;
+					break;
+				}
+			}
+		}
+		else if(global_state_cache.uniform_count < ARRAY_COUNT(global_state_cache.uniforms)) {
+			uniform = global_state_cache.uniforms + global_state_cache.uniform_count++;
+			uniform->program = global_state_cache.program;
+			uniform->location = location;
+		}
+
+		if(changed && uniform) {
+			uniform->count = count;
+			for(u32 i = 0; i < count; i++) {
+				uniform->v[i] = v[i];
+			}
+		}
+
+		return state_changed(changed);
+	}
+
+	void uniform1i(GLint location, GLint x) {
+		f32 v[1] = { (f32)x };
+		if(update_uniform_state(location, v, ARRAY_COUNT(v))) {
+			glUniform1i(location, x);
+		}
+	}
+
+	void uniform1f(GLint location, f32 x) {
+		f32 v[1] = { x };
+		if(update_uniform_state(location, v, ARRAY_COUNT(v))) {
+			glUniform1f(location, x);
+		}
+	}
+
+	void uniform2f(GLint location, f32 x, f32 y) {
+		f32 v[2] = { x, y };
+		if(update_uniform_state(location, v, ARRAY_COUNT(v))) {
+			glUniform2f(location, x, y);
+		}
+	}
+
+	void uniform4f(GLint location, f32 x, f32 y, f32 z, f32 w) {
+		f32 v[4] = { x, y, z, w };
+		if(update_uniform_state(location, v, ARRAY_COUNT(v))) {
+			glUniform4f(location, x, y, z, w);
+		}
+	}
+
+	void uniform_matrix3fv(GLint location, f32 const * m) {
+		if(update_uniform_state(location, m, 9)) {
+			glUniformMatrix3fv(location, 1, GL_FALSE, m);
+		}
+	}
+
 	GLuint compile_shader_from_source(char const * shader_src, GLenum shader_type) {
 		GLuint shader_id = glCreateShader(shader_type);
 		glShaderSource(shader_id, 1, &shader_src, 0);
@@ -114,29 +392,40 @@ namespace gl {
 		return program_id;
 	}
 
-	VertexBuffer create_vertex_buffer(f32 const * vert_data, u32 vert_data_length, u32 vert_size, GLenum usage_flag) {
+	VertexBuffer create_vertex_buffer(void const * vert_data, u32 vert_count, u32 vert_size, GLenum usage_flag) {
 		VertexBuffer vertex_buffer = {};
-		vertex_buffer.vert_count = vert_data_length / vert_size;
+		vertex_buffer.vert_count = vert_count;
 		vertex_buffer.vert_size = vert_size;
-		vertex_buffer.size_in_bytes = vert_data_length * sizeof(f32);
+		vertex_buffer.size_in_bytes = vert_count * vert_size;
 
 		glGenBuffers(1, &vertex_buffer.id);
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer.id);
+		bind_array_buffer(vertex_buffer.id);
 		glBufferData(GL_ARRAY_BUFFER, vertex_buffer.size_in_bytes, vert_data, usage_flag);
 
 		return vertex_buffer;
 	}
 
+	IndexBuffer create_index_buffer(u16 const * index_data, u32 index_count, GLenum usage_flag) {
+		IndexBuffer index_buffer = {};
+		index_buffer.index_count = index_count;
+
+		glGenBuffers(1, &index_buffer.id);
+		bind_element_array_buffer(index_buffer.id);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(u16), index_data, usage_flag);
+
+		return index_buffer;
+	}
+
 	FrameBuffer create_frame_buffer(u32 width, u32 height, b32 use_depth, GLint min_filter = GL_NEAREST, GLint mag_filter = GL_NEAREST) {
 		FrameBuffer frame_buffer = {};
 		frame_buffer.width = width;
 		frame_buffer.height = height;
 
 		glGenFramebuffers(1, &frame_buffer.id);
-		glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer.id);
+		bind_frame_buffer(frame_buffer.id);
 
 		glGenTextures(1, &frame_buffer.texture_id);
-		glBindTexture(GL_TEXTURE_2D, frame_buffer.texture_id);
+		bind_texture(frame_buffer.texture_id);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
@@ -144,7 +433,7 @@ namespace gl {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		bind_texture(0);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, frame_buffer.texture_id, 0);
 
 		if(use_depth) {
@@ -158,7 +447,7 @@ namespace gl {
 
 		ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		bind_frame_buffer(0);
 		return frame_buffer;
 	}
 
@@ -197,7 +486,20 @@ namespace gl {
 	}
 #endif
 
-	Texture create_texture(u8 * texture_data, u32 width, u32 height, GLenum format, GLint filter, GLint wrap_mode) {
+	u32 get_pixel_size(GLenum format, GLenum type) {
+		u32 size = 4;
+		if(type == GL_UNSIGNED_SHORT_5_6_5 || format == GL_LUMINANCE_ALPHA) {
+			size = 2;
+		}
+		else {
+			ASSERT(format == GL_RGBA && type == GL_UNSIGNED_BYTE);
+		}
+
+		return size;
+	}
+
+	//NOTE: Allocates storage for every mip level, WebGL needs the full chain down to 1x1 for mipped textures!!
+	Texture allocate_texture(u32 width, u32 height, GLenum format, GLenum type, GLint filter, GLint wrap_mode, u32 mip_levels = 1) {
 		Texture tex = {};
 		tex.width = width;
 		tex.height = height;
@@ -205,17 +507,50 @@ namespace gl {
 		glGenTextures(1, &tex.id);
 		ASSERT(tex.id);
 
-		glBindTexture(GL_TEXTURE_2D, tex.id);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, format, GL_UNSIGNED_BYTE, texture_data);
+		bind_texture(tex.id);
+		for(u32 i = 0; i < mip_levels; i++) {
+			glTexImage2D(GL_TEXTURE_2D, i, format, MAX(width >> i, 1), MAX(height >> i, 1), 0, format, type, 0);
+		}
+
+		GLint min_filter = filter;
+		if(mip_levels > 1) {
+			min_filter = filter == GL_NEAREST ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+		}
 
 		//TODO: Anisotropic filtering!!
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_mode);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_mode);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
 
 		GL_CHECK_ERRORS();
 
+		return tex;
+	}
+
+	void upload_texture_rows(Texture * tex, u32 level, u32 y, u32 rows, u8 const * row_data, GLenum format, GLenum type) {
+		bind_texture(tex->id);
+		//NOTE: 16 bit formats have 2 byte rows, so don't assume 4 byte alignment!!
+		set_unpack_alignment(1);
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, MAX(tex->width >> level, 1), rows, format, type, row_data);
+
+		GL_CHECK_ERRORS();
+	}
+
+	//NOTE: Mip levels are expected to follow level 0 tightly packed!!
+	Texture create_texture(u8 * texture_data, u32 width, u32 height, GLenum format, GLenum type, GLint filter, GLint wrap_mode, u32 mip_levels = 1) {
+		Texture tex = allocate_texture(width, height, format, type, filter, wrap_mode, mip_levels);
+
+		u32 pixel_size = get_pixel_size(format, type);
+		u8 * level_data = texture_data;
+		for(u32 i = 0; i < mip_levels; i++) {
+			u32 level_width = MAX(width >> i, 1);
+			u32 level_height = MAX(height >> i, 1);
+			upload_texture_rows(&tex, i, 0, level_height, level_data, format, type);
+
+			level_data += level_width * level_height * pixel_size;
+		}
+
 		return tex;
 	}	
 }
@@ -2,6 +2,7 @@
 #include <render.hpp>
 
 #include <basic.vert>
+#include <sprite.vert>
 #include <basic.frag>
 #include <screen_quad.vert>
 #include <post_filter.frag>
@@ -45,21 +46,42 @@ math::Vec3 unproject_pos(RenderTransform * transform, math::Vec2 pos, f32 z) {
 	return unprojected_pos;
 }
 
-RenderBatch * allocate_render_batch(MemoryArena * arena, Texture * tex, u32 v_len, RenderMode render_mode = RenderMode_triangles) {
+RenderBatch * allocate_render_batch(MemoryArena * arena, Texture * tex, u32 v_len, gl::IndexBuffer * i_buf, RenderMode render_mode = RenderMode_triangles) {
+	ASSERT(v_len % QUAD_VERT_COUNT == 0);
+	ASSERT((v_len * RENDER_BATCH_RING_SEGMENTS / QUAD_VERT_COUNT) * QUAD_INDEX_COUNT <= i_buf->index_count);
+
 	RenderBatch * batch = PUSH_STRUCT(arena, RenderBatch);
 
 	batch->tex = tex;
 
 	batch->v_len = v_len;
-	batch->v_arr = PUSH_ARRAY(arena, f32, batch->v_len);
-	batch->v_buf = gl::create_vertex_buffer(batch->v_arr, batch->v_len, VERT_ELEM_COUNT, GL_DYNAMIC_DRAW);
+	batch->v_arr = PUSH_ARRAY(arena, Vertex, batch->v_len);
 	batch->e = 0;
 
+	batch->v_buf = gl::create_vertex_buffer(0, batch->v_len * RENDER_BATCH_RING_SEGMENTS, sizeof(Vertex), GL_STREAM_DRAW);
+	batch->ring_pos = 0;
+	batch->i_buf = i_buf;
+
 	batch->mode = render_mode;
 
 	return batch;
 }
 
+void enable_render_batch_instancing(RenderBatch * batch, MemoryArena * arena, u32 instance_len, Shader * instance_shader, gl::VertexBuffer * corner_v_buf) {
+	ASSERT(instance_len);
+
+	batch->instanced = false;
+	batch->instance_len = instance_len;
+	batch->instance_arr = PUSH_ARRAY(arena, SpriteInstance, batch->instance_len);
+	batch->instance_e = 0;
+
+	batch->instance_buf = gl::create_vertex_buffer(0, batch->instance_len * RENDER_BATCH_RING_SEGMENTS, sizeof(SpriteInstance), GL_STREAM_DRAW);
+	batch->instance_ring_pos = 0;
+
+	batch->instance_shader = instance_shader;
+	batch->corner_v_buf = corner_v_buf;
+}
+
 FontLayout create_font_layout(Font * font, math::Vec2 dim, f32 scale, FontLayoutAnchor anchor, math::Vec2 offset = math::vec2(0.0f), b32 pixel_align = true) {
 	FontLayout layout = {};
 	layout.anchor = anchor;
@@ -112,90 +134,154 @@ FontLayout create_font_layout(Font * font, math::Vec2 dim, f32 scale, FontLayout
 	return layout;
 }
 
-void push_quad_to_batch(RenderBatch * batch, math::Vec2 pos0, math::Vec2 pos1, math::Vec2 uv0, math::Vec2 uv1, math::Vec4 color) {
-	ASSERT(batch->v_len >= QUAD_ELEM_COUNT);
-	ASSERT(batch->e <= (batch->v_len - QUAD_ELEM_COUNT));
-	f32 * v = batch->v_arr;
+inline u32 pack_color(math::Vec4 color) {
+	//NOTE: Premultiplied, byte order is r, g, b, a in memory!!
+	color = math::vec4(color.rgb * color.a, color.a);
 
-	color.rgb *= color.a;
+	u32 r = (u32)(math::clamp01(color.r) * 255.0f + 0.5f);
+	u32 g = (u32)(math::clamp01(color.g) * 255.0f + 0.5f);
+	u32 b = (u32)(math::clamp01(color.b) * 255.0f + 0.5f);
+	u32 a = (u32)(math::clamp01(color.a) * 255.0f + 0.5f);
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
 
-	v[batch->e++] =  pos0.x; v[batch->e++] =  pos0.y; v[batch->e++] =   uv0.x; v[batch->e++] =   uv0.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+inline u16 pack_uv(f32 uv) {
+	return (u16)(math::clamp01(uv) * 65535.0f + 0.5f);
+}
 
-	v[batch->e++] =  pos1.x; v[batch->e++] =  pos1.y; v[batch->e++] =   uv1.x; v[batch->e++] =   uv1.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+inline Vertex vertex(math::Vec2 pos, math::Vec2 uv, u32 packed_color) {
+	Vertex vert;
+	vert.pos = pos;
+	vert.uv[0] = pack_uv(uv.x);
+	vert.uv[1] = pack_uv(uv.y);
+	vert.color = packed_color;
+	return vert;
+}
 
-	v[batch->e++] =  pos0.x; v[batch->e++] =  pos1.y; v[batch->e++] =   uv0.x; v[batch->e++] =   uv1.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+void push_instance_to_batch(RenderBatch * batch, math::Vec2 pos, math::Vec2 dim, f32 angle, math::Vec2 uv0, math::Vec2 uv1, math::Vec4 color) {
+	ASSERT(batch->instanced);
+	ASSERT(batch->instance_e < batch->instance_len);
+
+	SpriteInstance * instance = batch->instance_arr + batch->instance_e++;
+	instance->pos = pos;
+	instance->dim = dim;
+	instance->angle = angle;
+	instance->uv[0] = pack_uv(uv0.x);
+	instance->uv[1] = pack_uv(uv0.y);
+	instance->uv[2] = pack_uv(uv1.x);
+	instance->uv[3] = pack_uv(uv1.y);
+	instance->color = pack_color(color);
+}
 
-	v[batch->e++] =  pos0.x; v[batch->e++] =  pos0.y; v[batch->e++] =   uv0.x; v[batch->e++] =   uv0.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+void push_quad_to_batch(RenderBatch * batch, math::Vec2 pos0, math::Vec2 pos1, math::Vec2 uv0, math::Vec2 uv1, math::Vec4 color) {
+	ASSERT(batch->v_len >= QUAD_VERT_COUNT);
+	ASSERT(batch->e <= (batch->v_len - QUAD_VERT_COUNT));
+	Vertex * v = batch->v_arr;
 
-	v[batch->e++] =  pos1.x; v[batch->e++] =  pos0.y; v[batch->e++] =   uv1.x; v[batch->e++] =   uv0.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+	u32 packed_color = pack_color(color);
 
-	v[batch->e++] =  pos1.x; v[batch->e++] =  pos1.y; v[batch->e++] =   uv1.x; v[batch->e++] =   uv1.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+	v[batch->e++] = vertex(pos0, uv0, packed_color);
+	v[batch->e++] = vertex(pos1, uv1, packed_color);
+	v[batch->e++] = vertex(math::vec2(pos0.x, pos1.y), math::vec2(uv0.x, uv1.y), packed_color);
+	v[batch->e++] = vertex(math::vec2(pos1.x, pos0.y), math::vec2(uv1.x, uv0.y), packed_color);
 }
 
 void push_rotated_quad_to_batch(RenderBatch * batch, math::Vec2 pos0, math::Vec2 pos1, math::Vec2 pos2, math::Vec2 pos3, math::Vec2 uv0, math::Vec2 uv1, math::Vec4 color) {
-	ASSERT(batch->v_len >= QUAD_ELEM_COUNT);
-	ASSERT(batch->e <= (batch->v_len - QUAD_ELEM_COUNT));
-	f32 * v = batch->v_arr;
+	ASSERT(batch->v_len >= QUAD_VERT_COUNT);
+	ASSERT(batch->e <= (batch->v_len - QUAD_VERT_COUNT));
+	Vertex * v = batch->v_arr;
 
-	color.rgb *= color.a;
+	u32 packed_color = pack_color(color);
+
+	v[batch->e++] = vertex(pos0, uv0, packed_color);
+	v[batch->e++] = vertex(pos1, uv1, packed_color);
+	v[batch->e++] = vertex(pos2, math::vec2(uv0.x, uv1.y), packed_color);
+	v[batch->e++] = vertex(pos3, math::vec2(uv1.x, uv0.y), packed_color);
+}
 
-	v[batch->e++] =  pos0.x; v[batch->e++] =  pos0.y; v[batch->e++] =   uv0.x; v[batch->e++] =   uv0.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+void push_quad_lines_to_batch(RenderBatch * batch, math::Rec2 * rec, math::Vec4 color) {
+	ASSERT(batch->v_len >= QUAD_LINES_VERT_COUNT);
+	ASSERT(batch->e <= (batch->v_len - QUAD_LINES_VERT_COUNT));
+	Vertex * v = batch->v_arr;
 
-	v[batch->e++] =  pos1.x; v[batch->e++] =  pos1.y; v[batch->e++] =   uv1.x; v[batch->e++] =   uv1.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+	u32 packed_color = pack_color(color);
+	math::Vec2 uv = math::vec2(0.0f);
+
+	math::Vec2 pos0 = rec->min;
+	math::Vec2 pos1 = rec->max;
 
-	v[batch->e++] =  pos2.x; v[batch->e++] =  pos2.y; v[batch->e++] =   uv0.x; v[batch->e++] =   uv1.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+	v[batch->e++] = vertex(pos0, uv, packed_color);
+	v[batch->e++] = vertex(math::vec2(pos1.x, pos0.y), uv, packed_color);
 
-	v[batch->e++] =  pos0.x; v[batch->e++] =  pos0.y; v[batch->e++] =   uv0.x; v[batch->e++] =   uv0.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+	v[batch->e++] = vertex(math::vec2(pos1.x, pos0.y), uv, packed_color);
+	v[batch->e++] = vertex(pos1, uv, packed_color);
 
-	v[batch->e++] =  pos3.x; v[batch->e++] =  pos3.y; v[batch->e++] =   uv1.x; v[batch->e++] =   uv0.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+	v[batch->e++] = vertex(pos1, uv, packed_color);
+	v[batch->e++] = vertex(math::vec2(pos0.x, pos1.y), uv, packed_color);
 
-	v[batch->e++] =  pos1.x; v[batch->e++] =  pos1.y; v[batch->e++] =   uv1.x; v[batch->e++] =   uv1.y;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+	v[batch->e++] = vertex(math::vec2(pos0.x, pos1.y), uv, packed_color);
+	v[batch->e++] = vertex(pos0, uv, packed_color);
 }
 
-void push_quad_lines_to_batch(RenderBatch * batch, math::Rec2 * rec, math::Vec4 color) {
-	ASSERT(batch->v_len >= QUAD_LINES_ELEM_COUNT);
-	ASSERT(batch->e <= (batch->v_len - QUAD_LINES_ELEM_COUNT));
-	f32 * v = batch->v_arr;
+u32 get_sprite_vert_count(Texture * sprite) {
+	//NOTE: Meshes are fans, every pair of fan triangles is one indexed quad!!
+	return sprite->mesh_vert_count ? ((sprite->mesh_vert_count - 1) / 2) * QUAD_VERT_COUNT : QUAD_VERT_COUNT;
+}
 
-	color.rgb *= color.a;
+//NOTE: Triangle fan over the sprite's outline, origin is the (-x,-y) corner and the axes span the whole sprite!!
+void push_sprite_mesh_to_batch(RenderBatch * batch, Texture * sprite, math::Vec2 origin, math::Vec2 x_axis, math::Vec2 y_axis, math::Vec4 color) {
+	u32 vert_count = get_sprite_vert_count(sprite);
+	ASSERT(batch->v_len >= vert_count);
+	ASSERT(batch->e <= (batch->v_len - vert_count));
+	Vertex * v = batch->v_arr;
 
-	math::Vec2 pos0 = rec->min;
-	math::Vec2 pos1 = rec->max;
+	u32 packed_color = pack_color(color);
 
-	v[batch->e++] =  pos0.x; v[batch->e++] =  pos0.y; v[batch->e++] =    0.0f; v[batch->e++] =    0.0f;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
-	v[batch->e++] =  pos1.x; v[batch->e++] =  pos0.y; v[batch->e++] =    0.0f; v[batch->e++] =    0.0f;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+	math::Vec2 uv0 = sprite->tex_coords[0];
+	math::Vec2 uv_dim = sprite->tex_coords[1] - uv0;
 
-	v[batch->e++] =  pos1.x; v[batch->e++] =  pos0.y; v[batch->e++] =    0.0f; v[batch->e++] =    0.0f;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
-	v[batch->e++] =  pos1.x; v[batch->e++] =  pos1.y; v[batch->e++] =    0.0f; v[batch->e++] =    0.0f;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+	math::Vec2 poss[SPRITE_MAX_MESH_VERTS];
+	math::Vec2 uvs[SPRITE_MAX_MESH_VERTS];
+	for(u32 i = 0; i < sprite->mesh_vert_count; i++) {
+		math::Vec2 vert = sprite->mesh_verts[i];
+		poss[i] = origin + x_axis * vert.x + y_axis * vert.y;
 
-	v[batch->e++] =  pos1.x; v[batch->e++] =  pos1.y; v[batch->e++] =    0.0f; v[batch->e++] =    0.0f;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
-	v[batch->e++] =  pos0.x; v[batch->e++] =  pos1.y; v[batch->e++] =    0.0f; v[batch->e++] =    0.0f;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+		if(sprite->rotated) {
+			uvs[i] = uv0 + uv_dim * math::vec2(vert.y, 1.0f - vert.x);
+		}
+		else {
+			uvs[i] = uv0 + uv_dim * vert;
+		}
+	}
+
+	//NOTE: Fan triangles (0, i, i + 1) and (0, i + 1, i + 2) as the quad (i + 1, 0, i, i + 2), an odd one out gets a degenerate second triangle!!
+	for(u32 i = 1; i < (sprite->mesh_vert_count - 1); i += 2) {
+		u32 last = (i + 2) < sprite->mesh_vert_count ? i + 2 : 0;
+		u32 indices[QUAD_VERT_COUNT] = { i + 1, 0, i, last };
+		for(u32 ii = 0; ii < ARRAY_COUNT(indices); ii++) {
+			math::Vec2 pos = poss[indices[ii]];
+			math::Vec2 uv = uvs[indices[ii]];
 
-	v[batch->e++] =  pos0.x; v[batch->e++] =  pos1.y; v[batch->e++] =    0.0f; v[batch->e++] =    0.0f;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
-	v[batch->e++] =  pos0.x; v[batch->e++] =  pos0.y; v[batch->e++] =    0.0f; v[batch->e++] =    0.0f;
-	v[batch->e++] = color.r; v[batch->e++] = color.g; v[batch->e++] = color.b; v[batch->e++] = color.a;
+			v[batch->e++] = vertex(pos, uv, packed_color);
+		}
+	}
 }
 
 void push_sprite_to_batch(RenderBatch * batch, Texture * sprite, math::Vec2 pos, math::Vec2 dim, f32 angle, math::Vec4 color) {
+	if(batch->instanced) {
+		//NOTE: Meshes still have to go through the vertex path!!
+		ASSERT(!sprite->mesh_vert_count);
+
+		//NOTE: Rotated sprites sit a quarter turn round in the atlas, so draw the atlas rect turned back with the dims swapped!!
+		if(sprite->rotated) {
+			angle += math::TAU * 0.25f;
+			dim = math::vec2(dim.y, dim.x);
+		}
+
+		push_instance_to_batch(batch, pos, dim, angle, sprite->tex_coords[0], sprite->tex_coords[1], color);
+		return;
+	}
+
 	math::Vec2 x_axis = math::vec2(math::cos(angle), math::sin(angle));
 	math::Vec2 y_axis = math::perp(x_axis);
 
@@ -210,50 +296,188 @@ void push_sprite_to_batch(RenderBatch * batch, Texture * sprite, math::Vec2 pos,
 	math::Vec2 uv0 = sprite->tex_coords[0];
 	math::Vec2 uv1 = sprite->tex_coords[1];
 
-	push_rotated_quad_to_batch(batch, pos0, pos1, pos2, pos3, uv0, uv1, color);
+	if(sprite->mesh_vert_count) {
+		push_sprite_mesh_to_batch(batch, sprite, pos0, x_axis * 2.0f, y_axis * 2.0f, color);
+	}
+	else if(sprite->rotated) {
+		//NOTE: Shift the corners round one so the uvs undo the rotation in the atlas!!
+		push_rotated_quad_to_batch(batch, pos3, pos2, pos0, pos1, uv0, uv1, color);
+	}
+	else {
+		push_rotated_quad_to_batch(batch, pos0, pos1, pos2, pos3, uv0, uv1, color);
+	}
 }
 
-void render_v_buf(gl::VertexBuffer * v_buf, RenderMode render_mode, Shader * shader, math::Mat3 * transform, Texture * tex0, math::Vec4 color = math::vec4(1.0f)) {
-	DEBUG_TIME_BLOCK();
+//NOTE: Full textures go through the batch as well, scrollable ones repeat once either side!!
+void push_texture_to_batch(RenderBatch * batch, math::Vec2 pos, math::Vec2 dim, f32 angle, math::Vec4 color, b32 scrollable) {
+	math::Vec2 x_axis = math::vec2(math::cos(angle), math::sin(angle));
+	math::Vec2 y_axis = math::perp(x_axis);
+
+	x_axis *= dim.x * 0.5f;
+	y_axis *= dim.y * 0.5f;
+
+	math::Vec2 uv0 = math::vec2(0.0f);
+	math::Vec2 uv1 = math::vec2(1.0f);
+
+	i32 repeat = scrollable ? 1 : 0;
+	for(i32 i = -repeat; i <= repeat; i++) {
+		math::Vec2 centre = pos + x_axis * (2.0f * (f32)i);
+
+		if(batch->instanced) {
+			push_instance_to_batch(batch, centre, dim, angle, uv0, uv1, color);
+			continue;
+		}
+
+		math::Vec2 pos0 = centre - x_axis - y_axis;
+		math::Vec2 pos1 = centre + x_axis + y_axis;
+		math::Vec2 pos2 = centre - x_axis + y_axis;
+		math::Vec2 pos3 = centre + x_axis - y_axis;
+
+		push_rotated_quad_to_batch(batch, pos0, pos1, pos2, pos3, uv0, uv1, color);
+	}
+}
 
-	glUseProgram(shader->id);
+void set_shader_uniforms(Shader * shader, math::Mat3 * transform, Texture * tex0, math::Vec4 color, f32 sdf_edge) {
+	gl::use_program(shader->id);
 
-	// glUniformMatrix4fv(shader->transform, 1, GL_FALSE, transform->v);
-	glUniformMatrix3fv(shader->transform, 1, GL_FALSE, transform->v);
+	gl::uniform_matrix3fv(shader->transform, transform->v);
 
 	color.rgb *= color.a;
-	glUniform4f(shader->color, color.r, color.g, color.b, color.a);
+	gl::uniform4f(shader->color, color.r, color.g, color.b, color.a);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, tex0->gl_id);
-	glUniform1i(shader->tex0, 0);
+	gl::active_texture(GL_TEXTURE0);
+	gl::bind_texture(tex0->gl_id);
+	gl::uniform1i(shader->tex0, 0);
+	gl::uniform1f(shader->sdf_edge, tex0->sdf ? sdf_edge : 0.0f);
+}
+
+//NOTE: Indexed when there's an index buffer, first_vert has to be at the start of a quad then!!
+void render_v_buf(gl::VertexBuffer * v_buf, gl::IndexBuffer * i_buf, RenderMode render_mode, Shader * shader, math::Mat3 * transform, Texture * tex0, math::Vec4 color = math::vec4(1.0f), f32 sdf_edge = 0.0f, u32 first_vert = 0) {
+	DEBUG_TIME_BLOCK();
+
+	set_shader_uniforms(shader, transform, tex0, color, sdf_edge);
+
+	gl::bind_array_buffer(v_buf->id);
+
+	ASSERT(v_buf->vert_size == sizeof(Vertex));
+	u32 stride = sizeof(Vertex);
+
+	gl::vertex_attrib_pointer(shader->i_position, 2, GL_FLOAT, GL_FALSE, stride, (void *)OFFSET_OF(Vertex, pos));
+	gl::vertex_attrib_divisor(shader->i_position, 0);
 
-	glBindBuffer(GL_ARRAY_BUFFER, v_buf->id);
+	gl::vertex_attrib_pointer(shader->i_tex_coord, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *)OFFSET_OF(Vertex, uv));
+	gl::vertex_attrib_divisor(shader->i_tex_coord, 0);
 
-	u32 stride = v_buf->vert_size * sizeof(f32);
+	gl::vertex_attrib_pointer(shader->i_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *)OFFSET_OF(Vertex, color));
+	gl::vertex_attrib_divisor(shader->i_color, 0);
 
-	glVertexAttribPointer(shader->i_position, 2, GL_FLOAT, 0, stride, 0);
-	glEnableVertexAttribArray(shader->i_position);
+	gl::enable_vertex_attrib_arrays((1 << shader->i_position) | (1 << shader->i_tex_coord) | (1 << shader->i_color));
 
-	glVertexAttribPointer(shader->i_tex_coord, 2, GL_FLOAT, 0, stride, (void *)(2 * sizeof(f32)));
-	glEnableVertexAttribArray(shader->i_tex_coord);
+	if(i_buf) {
+		ASSERT(first_vert % QUAD_VERT_COUNT == 0 && v_buf->vert_count % QUAD_VERT_COUNT == 0);
 
-	glVertexAttribPointer(shader->i_color, 4, GL_FLOAT, 0, stride, (void *)(4 * sizeof(f32)));
-	glEnableVertexAttribArray(shader->i_color);
+		u32 first_index = (first_vert / QUAD_VERT_COUNT) * QUAD_INDEX_COUNT;
+		u32 index_count = (v_buf->vert_count / QUAD_VERT_COUNT) * QUAD_INDEX_COUNT;
+		ASSERT(first_index + index_count <= i_buf->index_count);
 
-	glDrawArrays(render_mode, 0, v_buf->vert_count);
+		gl::bind_element_array_buffer(i_buf->id);
+		glDrawElements(render_mode, index_count, GL_UNSIGNED_SHORT, (void *)(first_index * sizeof(u16)));
+	}
+	else {
+		glDrawArrays(render_mode, first_vert, v_buf->vert_count);
+	}
+}
+
+//NOTE: One indexed quad per instance, the instance attribs are offset to first_instance since WebGL 1 has no base instance!!
+void render_instance_buf(gl::VertexBuffer * instance_buf, gl::VertexBuffer * corner_v_buf, gl::IndexBuffer * i_buf, Shader * shader, math::Mat3 * transform, Texture * tex0, f32 sdf_edge, u32 first_instance) {
+	DEBUG_TIME_BLOCK();
+
+	set_shader_uniforms(shader, transform, tex0, math::vec4(1.0f), sdf_edge);
+
+	gl::bind_array_buffer(corner_v_buf->id);
+	ASSERT(corner_v_buf->vert_count == QUAD_VERT_COUNT);
+	gl::vertex_attrib_pointer(shader->i_corner, 2, GL_FLOAT, GL_FALSE, corner_v_buf->vert_size, 0);
+	gl::vertex_attrib_divisor(shader->i_corner, 0);
+
+	gl::bind_array_buffer(instance_buf->id);
+
+	ASSERT(instance_buf->vert_size == sizeof(SpriteInstance));
+	u32 stride = sizeof(SpriteInstance);
+	size_t first = first_instance * stride;
+
+	gl::vertex_attrib_pointer(shader->i_position, 2, GL_FLOAT, GL_FALSE, stride, (void *)(first + OFFSET_OF(SpriteInstance, pos)));
+	gl::vertex_attrib_divisor(shader->i_position, 1);
+
+	gl::vertex_attrib_pointer(shader->i_dim, 2, GL_FLOAT, GL_FALSE, stride, (void *)(first + OFFSET_OF(SpriteInstance, dim)));
+	gl::vertex_attrib_divisor(shader->i_dim, 1);
+
+	gl::vertex_attrib_pointer(shader->i_angle, 1, GL_FLOAT, GL_FALSE, stride, (void *)(first + OFFSET_OF(SpriteInstance, angle)));
+	gl::vertex_attrib_divisor(shader->i_angle, 1);
+
+	gl::vertex_attrib_pointer(shader->i_uv_rect, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *)(first + OFFSET_OF(SpriteInstance, uv)));
+	gl::vertex_attrib_divisor(shader->i_uv_rect, 1);
+
+	gl::vertex_attrib_pointer(shader->i_color, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *)(first + OFFSET_OF(SpriteInstance, color)));
+	gl::vertex_attrib_divisor(shader->i_color, 1);
+
+	gl::enable_vertex_attrib_arrays((1 << shader->i_corner) | (1 << shader->i_position) | (1 << shader->i_dim) | (1 << shader->i_angle) | (1 << shader->i_uv_rect) | (1 << shader->i_color));
+
+	gl::bind_element_array_buffer(i_buf->id);
+	gl::draw_elements_instanced(GL_TRIANGLES, QUAD_INDEX_COUNT, GL_UNSIGNED_SHORT, 0, instance_buf->vert_count);
 }
 
 void render_and_clear_render_batch(RenderBatch * batch, Shader * shader, math::Mat3 * transform) {
 	DEBUG_TIME_BLOCK();
 
+	if(batch->instance_e > 0) {
+		ASSERT(batch->instanced && batch->mode == RenderMode_triangles);
+
+		u32 instance_count = batch->instance_e;
+		u32 instance_capacity = batch->instance_len * RENDER_BATCH_RING_SEGMENTS;
+
+		gl::bind_array_buffer(batch->instance_buf.id);
+
+		if(batch->instance_ring_pos + instance_count > instance_capacity) {
+			glBufferData(GL_ARRAY_BUFFER, batch->instance_buf.size_in_bytes, 0, GL_STREAM_DRAW);
+			batch->instance_ring_pos = 0;
+		}
+
+		glBufferSubData(GL_ARRAY_BUFFER, batch->instance_ring_pos * sizeof(SpriteInstance), instance_count * sizeof(SpriteInstance), batch->instance_arr);
+		batch->debug_bytes_uploaded += instance_count * sizeof(SpriteInstance);
+
+		batch->instance_buf.vert_count = instance_count;
+
+		render_instance_buf(&batch->instance_buf, batch->corner_v_buf, batch->i_buf, batch->instance_shader, transform, batch->tex, batch->sdf_edge, batch->instance_ring_pos);
+		batch->debug_draw_call_count++;
+
+		batch->instance_ring_pos += instance_count;
+
+		batch->instance_e = 0;
+	}
+
 	if(batch->e > 0) {
-		glBindBuffer(GL_ARRAY_BUFFER, batch->v_buf.id);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, batch->v_buf.size_in_bytes, batch->v_arr);
+		u32 vert_count = batch->e;
+		u32 vert_capacity = batch->v_len * RENDER_BATCH_RING_SEGMENTS;
+
+		gl::bind_array_buffer(batch->v_buf.id);
+
+		//NOTE: Orphan the buffer once it's full, the driver hands back fresh storage rather than waiting on the old draws!!
+		if(batch->ring_pos + vert_count > vert_capacity) {
+			glBufferData(GL_ARRAY_BUFFER, batch->v_buf.size_in_bytes, 0, GL_STREAM_DRAW);
+			batch->ring_pos = 0;
+		}
+
+		glBufferSubData(GL_ARRAY_BUFFER, batch->ring_pos * sizeof(Vertex), vert_count * sizeof(Vertex), batch->v_arr);
+		batch->debug_bytes_uploaded += vert_count * sizeof(Vertex);
+
 		//TODO: This is a bit ugly!!
-		batch->v_buf.vert_count = batch->e / VERT_ELEM_COUNT;
+		batch->v_buf.vert_count = vert_count;
+
+		gl::IndexBuffer * i_buf = batch->mode == RenderMode_triangles ? batch->i_buf : 0;
+		render_v_buf(&batch->v_buf, i_buf, batch->mode, shader, transform, batch->tex, math::vec4(1.0f), batch->sdf_edge, batch->ring_pos);
+		batch->debug_draw_call_count++;
 
-		render_v_buf(&batch->v_buf, batch->mode, shader, transform, batch->tex);
+		batch->ring_pos += vert_count;
 
 		batch->e = 0;
 	}
@@ -279,6 +503,24 @@ void load_render(RenderState * render_state, MemoryArena * arena, AssetState * a
 	basic_shader->transform = glGetUniformLocation(basic_shader->id, "transform");
 	basic_shader->color = glGetUniformLocation(basic_shader->id, "color");
 	basic_shader->tex0 = glGetUniformLocation(basic_shader->id, "tex0");
+	basic_shader->sdf_edge = glGetUniformLocation(basic_shader->id, "sdf_edge");
+
+	Shader * sprite_shader = &render_state->sprite_shader;
+	render_state->instancing = gl::instancing_supported();
+	if(render_state->instancing) {
+		u32 sprite_vert = gl::compile_shader_from_source(SPRITE_VERT_SRC, GL_VERTEX_SHADER);
+		sprite_shader->id = gl::link_shader_program(sprite_vert, basic_frag);
+		sprite_shader->i_corner = glGetAttribLocation(sprite_shader->id, "i_corner");
+		sprite_shader->i_position = glGetAttribLocation(sprite_shader->id, "i_position");
+		sprite_shader->i_dim = glGetAttribLocation(sprite_shader->id, "i_dim");
+		sprite_shader->i_angle = glGetAttribLocation(sprite_shader->id, "i_angle");
+		sprite_shader->i_uv_rect = glGetAttribLocation(sprite_shader->id, "i_uv_rect");
+		sprite_shader->i_color = glGetAttribLocation(sprite_shader->id, "i_color");
+		sprite_shader->transform = glGetUniformLocation(sprite_shader->id, "transform");
+		sprite_shader->color = glGetUniformLocation(sprite_shader->id, "color");
+		sprite_shader->tex0 = glGetUniformLocation(sprite_shader->id, "tex0");
+		sprite_shader->sdf_edge = glGetUniformLocation(sprite_shader->id, "sdf_edge");
+	}
 
 	Shader * post_shader = &render_state->post_shader;
 	u32 post_vert = gl::compile_shader_from_source(SCREEN_QUAD_VERT_SRC, GL_VERTEX_SHADER);
@@ -289,9 +531,16 @@ void load_render(RenderState * render_state, MemoryArena * arena, AssetState * a
 	post_shader->pixelate_scale = glGetUniformLocation(post_shader->id, "pixelate_scale");
 	post_shader->pixelate_dim = glGetUniformLocation(post_shader->id, "pixelate_dim");
 	post_shader->brightness = glGetUniformLocation(post_shader->id, "brightness");
+	post_shader->uv_scale = glGetUniformLocation(post_shader->id, "uv_scale");
 
 	render_state->frame_buffer = gl::create_frame_buffer(back_buffer_width, back_buffer_height, false);
 
+	render_state->render_scale = RENDER_SCALE_MAX;
+	render_state->render_scale_failed = RENDER_SCALE_MAX + RENDER_SCALE_STEP;
+	render_state->render_scale_retry_hold_time = RENDER_SCALE_RETRY_HOLD_TIME;
+	render_state->render_width = back_buffer_width;
+	render_state->render_height = back_buffer_height;
+
 	f32 screen_quad_verts[] = {
 		-1.0f,-1.0f,
 		 1.0f, 1.0f,
@@ -301,102 +550,228 @@ void load_render(RenderState * render_state, MemoryArena * arena, AssetState * a
 		 1.0f, 1.0f,
 	};
 
-	render_state->screen_quad_v_buf = gl::create_vertex_buffer(screen_quad_verts, ARRAY_COUNT(screen_quad_verts), 2, GL_STATIC_DRAW);
+	render_state->screen_quad_v_buf = gl::create_vertex_buffer(screen_quad_verts, ARRAY_COUNT(screen_quad_verts) / 2, sizeof(f32) * 2, GL_STATIC_DRAW);
 
-	f32 quad_verts[] = {
-		-0.5f,-0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 0.5f, 0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		-0.5f, 0.5f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		-0.5f,-0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 0.5f,-0.5f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 0.5f, 0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-	};
+	{
+		//NOTE: One static index buffer covers every quad in the batch ring, u16 indices so it has to fit in 64k verts!!
+		u32 quad_count = (RENDER_BATCH_MAX_VERTS * RENDER_BATCH_RING_SEGMENTS) / QUAD_VERT_COUNT;
+		ASSERT(quad_count * QUAD_VERT_COUNT <= 65536);
+
+		u16 * indices = ALLOC_ARRAY(u16, quad_count * QUAD_INDEX_COUNT);
+		for(u32 i = 0; i < quad_count; i++) {
+			u16 * quad_indices = indices + i * QUAD_INDEX_COUNT;
+			u16 first = (u16)(i * QUAD_VERT_COUNT);
+
+			quad_indices[0] = first + 0;
+			quad_indices[1] = first + 1;
+			quad_indices[2] = first + 2;
+			quad_indices[3] = first + 0;
+			quad_indices[4] = first + 3;
+			quad_indices[5] = first + 1;
+		}
 
-	render_state->quad_v_buf = gl::create_vertex_buffer(quad_verts, ARRAY_COUNT(quad_verts), VERT_ELEM_COUNT, GL_STATIC_DRAW);
-
-	f32 scrollable_quad_verts[] = {
-		-1.5f,-0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		-0.5f, 0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		-1.5f, 0.5f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		-1.5f,-0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		-0.5f,-0.5f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		-0.5f, 0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-
-		-0.5f,-0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 0.5f, 0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		-0.5f, 0.5f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		-0.5f,-0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 0.5f,-0.5f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 0.5f, 0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-
-		 0.5f,-0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 1.5f, 0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 0.5f, 0.5f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 0.5f,-0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 1.5f,-0.5f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-		 1.5f, 0.5f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
-	};
+		render_state->quad_i_buf = gl::create_index_buffer(indices, quad_count * QUAD_INDEX_COUNT, GL_STATIC_DRAW);
+		FREE_MEMORY(indices);
+	}
 
-	render_state->scrollable_quad_v_buf = gl::create_vertex_buffer(scrollable_quad_verts, ARRAY_COUNT(scrollable_quad_verts), VERT_ELEM_COUNT, GL_STATIC_DRAW);
+	render_state->render_batch = allocate_render_batch(render_state->arena, get_texture_asset(assets, AssetId_white, 0), RENDER_BATCH_MAX_VERTS, &render_state->quad_i_buf);
 
-	render_state->render_batch = allocate_render_batch(render_state->arena, get_texture_asset(assets, AssetId_white, 0), QUAD_ELEM_COUNT * 512);
+	if(render_state->instancing) {
+		//NOTE: Corners in the same order as the quad verts so the shared index buffer works for instances too!!
+		f32 quad_corners[] = {
+			0.0f, 0.0f,
+			1.0f, 1.0f,
+			0.0f, 1.0f,
+			1.0f, 0.0f,
+		};
+
+		render_state->quad_corner_v_buf = gl::create_vertex_buffer(quad_corners, ARRAY_COUNT(quad_corners) / 2, sizeof(f32) * 2, GL_STATIC_DRAW);
+		enable_render_batch_instancing(render_state->render_batch, render_state->arena, RENDER_BATCH_MAX_INSTANCES, sprite_shader, &render_state->quad_corner_v_buf);
+	}
 
 	glEnable(GL_CULL_FACE);
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+f32 get_pixelate_scale(RenderState * render_state) {
+	f32 pixelate_time = render_state->pixelate_time;
+	f32 pixelate_scale = math::frac(pixelate_time);
+	if((u32)pixelate_time & 1) {
+		pixelate_scale = 1.0f - pixelate_scale;
+	}
+
+	return 1.0f / math::pow(2.0f, (pixelate_scale * 8.0f));
+}
+
+f32 get_fade_brightness(RenderState * render_state) {
+	return 1.0 - math::clamp01(render_state->fade_amount);
+}
+
+//NOTE: Smoothed frame time against the observed refresh interval, a step only happens once a side has held for a while and there's a cooldown after!!
+void update_render_scale(RenderState * render_state, f32 delta_time) {
+	if(delta_time <= 0.0f || delta_time > RENDER_SCALE_MAX_FRAME_TIME) {
+		return;
+	}
+
+	//NOTE: Seed from the first real frame rather than assuming 60Hz, displays run at 50Hz or get throttled to 30fps!!
+	if(!render_state->render_scale_refresh_time) {
+		render_state->render_scale_frame_time = delta_time;
+		render_state->render_scale_refresh_time = delta_time;
+	}
+
+	render_state->render_scale_frame_time = math::lerp(render_state->render_scale_frame_time, delta_time, 0.1f);
+
+	f32 frame_time = render_state->render_scale_frame_time;
+	if(frame_time < render_state->render_scale_refresh_time) {
+		render_state->render_scale_refresh_time = frame_time;
+	}
+	else if(render_state->render_scale == RENDER_SCALE_MAX && render_state->render_scale_direction >= 0) {
+		//NOTE: Only creep up at full scale, otherwise a long fill bound stretch passes for the refresh interval and the scale climbs straight back into it!!
+		render_state->render_scale_refresh_time = math::lerp(render_state->render_scale_refresh_time, frame_time, math::min(RENDER_SCALE_REFRESH_RISE_RATE * delta_time, 1.0f));
+	}
+
+	if(render_state->render_scale_cooldown > 0.0f) {
+		render_state->render_scale_cooldown -= delta_time;
+		return;
+	}
+
+	f32 target_frame_time = render_state->render_scale_refresh_time;
+
+	i32 direction = 0;
+	if(frame_time > target_frame_time * RENDER_SCALE_DROP_THRESHOLD && render_state->render_scale > RENDER_SCALE_MIN) {
+		direction = -1;
+	}
+	else if(frame_time < target_frame_time * RENDER_SCALE_RAISE_THRESHOLD && render_state->render_scale < RENDER_SCALE_MAX) {
+		direction = 1;
+	}
+
+	if(direction != render_state->render_scale_direction) {
+		render_state->render_scale_direction = direction;
+		render_state->render_scale_hold_time = 0.0f;
+	}
+
+	render_state->render_scale_hold_time += delta_time;
+
+	f32 next_scale = math::clamp(render_state->render_scale + RENDER_SCALE_STEP * (f32)direction, RENDER_SCALE_MIN, RENDER_SCALE_MAX);
+
+	f32 hold_time = RENDER_SCALE_DROP_HOLD_TIME;
+	if(direction > 0) {
+		hold_time = next_scale >= render_state->render_scale_failed ? render_state->render_scale_retry_hold_time : RENDER_SCALE_RAISE_HOLD_TIME;
+	}
+
+	if(direction && render_state->render_scale_hold_time >= hold_time) {
+		if(direction < 0) {
+			if(render_state->render_scale == render_state->render_scale_failed) {
+				render_state->render_scale_retry_hold_time = math::min(render_state->render_scale_retry_hold_time * 2.0f, RENDER_SCALE_MAX_RETRY_HOLD_TIME);
+			}
+			else {
+				render_state->render_scale_retry_hold_time = RENDER_SCALE_RETRY_HOLD_TIME;
+			}
+
+			render_state->render_scale_failed = render_state->render_scale;
+		}
+
+		render_state->render_scale = next_scale;
+
+		render_state->render_scale_direction = 0;
+		render_state->render_scale_hold_time = 0.0f;
+		render_state->render_scale_cooldown = RENDER_SCALE_COOLDOWN_TIME;
+	}
 }
 
 void begin_render(RenderState * render_state) {
-	glBindFramebuffer(GL_FRAMEBUFFER, render_state->frame_buffer.id);
-	glViewport(0, 0, render_state->frame_buffer.width, render_state->frame_buffer.height);
+	f32 render_scale = render_state->render_scale;
+	render_state->render_width = MAX((u32)(render_state->frame_buffer.width * render_scale + 0.5f), 1);
+	render_state->render_height = MAX((u32)(render_state->frame_buffer.height * render_scale + 0.5f), 1);
+
+	//NOTE: The post filter is a straight copy unless a transition is pixelating or fading or the scene is scaled down, so only go through the frame buffer then!!
+	render_state->post_filter = get_pixelate_scale(render_state) < 1.0f || get_fade_brightness(render_state) < 1.0f || render_scale < 1.0f;
+
+	if(render_state->post_filter) {
+		gl::bind_frame_buffer(render_state->frame_buffer.id);
+		glViewport(0, 0, render_state->render_width, render_state->render_height);
+	}
+	else {
+		render_state->render_width = render_state->back_buffer_width;
+		render_state->render_height = render_state->back_buffer_height;
+
+		gl::bind_frame_buffer(0);
+		glViewport(0, 0, render_state->back_buffer_width, render_state->back_buffer_height);
+	}
+
 	glClear(GL_COLOR_BUFFER_BIT);
 
+	//NOTE: Alpha stays at the cleared 1 so drawing straight to the back buffer matches the post filter's opaque output!!
 	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
 }
 
 void end_render(RenderState * render_state) {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glViewport(0, 0, render_state->back_buffer_width, render_state->back_buffer_height);
-	glClear(GL_COLOR_BUFFER_BIT);
-
 	Shader * basic_shader = &render_state->basic_shader;
 	Shader * post_shader = &render_state->post_shader;
 
-	{
+	glDisable(GL_BLEND);
+
+	render_state->debug_post_filter_pixels_saved = render_state->back_buffer_width * render_state->back_buffer_height;
+
+	if(render_state->post_filter) {
+		gl::bind_frame_buffer(0);
+		glViewport(0, 0, render_state->back_buffer_width, render_state->back_buffer_height);
+		glClear(GL_COLOR_BUFFER_BIT);
+
 		gl::VertexBuffer * v_buf = &render_state->screen_quad_v_buf;
 
-		glUseProgram(post_shader->id);
+		gl::use_program(post_shader->id);
 
-		f32 pixelate_time = render_state->pixelate_time;
-		f32 pixelate_scale = math::frac(pixelate_time);
-		if((u32)pixelate_time & 1) {
-			pixelate_scale = 1.0f - pixelate_scale;
-		}
+		f32 pixelate_scale = get_pixelate_scale(render_state);
+		gl::uniform1f(post_shader->pixelate_scale, pixelate_scale);
 
-		pixelate_scale = 1.0f / math::pow(2.0f, (pixelate_scale * 8.0f));
-		glUniform1f(post_shader->pixelate_scale, pixelate_scale);
+		//NOTE: Only the scene's corner of the frame buffer gets sampled!!
+		math::Vec2 fb_dim = math::vec2((f32)render_state->frame_buffer.width, (f32)render_state->frame_buffer.height);
+		math::Vec2 uv_scale = math::vec2((f32)render_state->render_width, (f32)render_state->render_height) / fb_dim;
+		gl::uniform2f(post_shader->uv_scale, uv_scale.x, uv_scale.y);
 
-		math::Vec2 pixelate_dim = math::vec2((f32)render_state->frame_buffer.width, (f32)render_state->frame_buffer.height) * pixelate_scale;
-		glUniform4f(post_shader->pixelate_dim, pixelate_dim.x, pixelate_dim.y, 1.0f / pixelate_dim.x, 1.0f / pixelate_dim.y);
+		//NOTE: Pixelate cells stay the same size on screen whatever the render scale!!
+		math::Vec2 pixelate_dim = (fb_dim * pixelate_scale) / uv_scale;
+		gl::uniform4f(post_shader->pixelate_dim, pixelate_dim.x, pixelate_dim.y, 1.0f / pixelate_dim.x, 1.0f / pixelate_dim.y);
 
-		f32 brightness = 1.0 - math::clamp01(render_state->fade_amount);
-		glUniform1f(post_shader->brightness, brightness);
+		f32 brightness = get_fade_brightness(render_state);
+		gl::uniform1f(post_shader->brightness, brightness);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, render_state->frame_buffer.texture_id);
-		glUniform1i(post_shader->tex0, 0);
+		gl::active_texture(GL_TEXTURE0);
+		gl::bind_texture(render_state->frame_buffer.texture_id);
+		gl::uniform1i(post_shader->tex0, 0);
 
-		glBindBuffer(GL_ARRAY_BUFFER, v_buf->id);
+		gl::bind_array_buffer(v_buf->id);
 
-		u32 stride = v_buf->vert_size * sizeof(f32);
+		u32 stride = v_buf->vert_size;
 
-		glVertexAttribPointer(post_shader->i_position, 2, GL_FLOAT, 0, stride, 0);
-		glEnableVertexAttribArray(post_shader->i_position);
+		gl::vertex_attrib_pointer(post_shader->i_position, 2, GL_FLOAT, 0, stride, 0);
+		gl::vertex_attrib_divisor(post_shader->i_position, 0);
+		gl::enable_vertex_attrib_arrays(1 << post_shader->i_position);
 
 		glDrawArrays(GL_TRIANGLES, 0, v_buf->vert_count);
+
+		render_state->render_batch->debug_draw_call_count++;
+		render_state->debug_post_filter_pixels_saved = 0;
 	}
 
-	glDisable(GL_BLEND);
+	//NOTE: Every batch flush plus the post filter pass when there was one!!
+	render_state->debug_draw_call_count = render_state->render_batch->debug_draw_call_count;
+	render_state->render_batch->debug_draw_call_count = 0;
+
+	render_state->debug_bytes_uploaded = render_state->render_batch->debug_bytes_uploaded;
+	render_state->render_batch->debug_bytes_uploaded = 0;
+
+	render_state->debug_culled_count = render_state->debug_frame_culled_count;
+	render_state->debug_drawn_count = render_state->debug_frame_drawn_count;
+	render_state->debug_frame_culled_count = 0;
+	render_state->debug_frame_drawn_count = 0;
+
+	render_state->debug_gl_calls_made = gl::global_state_cache.debug_calls_made;
+	render_state->debug_gl_calls_skipped = gl::global_state_cache.debug_calls_skipped;
+	gl::global_state_cache.debug_calls_made = 0;
+	gl::global_state_cache.debug_calls_skipped = 0;
 }
 
 RenderGroup * allocate_render_group(RenderState * render_state, MemoryArena * arena, u32 projection_width, u32 projection_height, u32 max_elem_count = 256) {
@@ -406,6 +781,11 @@ RenderGroup * allocate_render_group(RenderState * render_state, MemoryArena * ar
 	render_group->elem_count = 0;
 	render_group->elems = PUSH_ARRAY(arena, RenderElement, render_group->max_elem_count);
 
+	ASSERT(render_group->max_elem_count <= (1 << RENDER_SORT_ORDER_BITS));
+	render_group->layer = 0;
+	render_group->sort_entries = PUSH_ARRAY(arena, RenderSortEntry, render_group->max_elem_count);
+	render_group->sort_temp = PUSH_ARRAY(arena, RenderSortEntry, render_group->max_elem_count);
+
 	render_group->assets = render_state->assets;
 
 	render_group->transform = create_render_transform(projection_width, projection_height);
@@ -414,6 +794,74 @@ RenderGroup * allocate_render_group(RenderState * render_state, MemoryArena * ar
 	return render_group;
 }
 
+void set_render_layer(RenderGroup * render_group, u32 layer) {
+	ASSERT(layer < (1 << RENDER_SORT_LAYER_BITS));
+	render_group->layer = layer;
+}
+
+//NOTE: Farther z sorts first, the float bits are flipped so they compare as unsigned and only the top bits are kept!!
+u64 get_render_sort_key(u32 layer, f32 z, u32 batch_id, u32 order) {
+	union { f32 f; u32 u; } z_bits;
+	z_bits.f = z;
+
+	u32 depth = (z_bits.u & 0x80000000) ? ~z_bits.u : (z_bits.u | 0x80000000);
+	depth = ~depth >> (32 - RENDER_SORT_DEPTH_BITS);
+
+	u64 key = layer;
+	key = (key << RENDER_SORT_DEPTH_BITS) | depth;
+	key = (key << RENDER_SORT_BATCH_BITS) | (batch_id & ((1 << RENDER_SORT_BATCH_BITS) - 1));
+	key = (key << RENDER_SORT_ORDER_BITS) | order;
+	return key;
+}
+
+//NOTE: Elements that can share a batch get the same id, quad sprites and meshes are kept apart since they flush when instancing!!
+u32 get_render_batch_id(AssetState * assets, Asset * asset) {
+	u32 batch_id = 0;
+	if(asset->type == AssetType_texture) {
+		batch_id = asset->texture.gl_id << 1;
+	}
+	else {
+		Texture * atlas = get_texture_asset(assets, AssetId_atlas, asset->sprite.atlas_index);
+		batch_id = (atlas->gl_id << 1) | (asset->sprite.mesh_vert_count ? 1 : 0);
+	}
+
+	return batch_id;
+}
+
+//NOTE: LSD radix sort on 8 bit digits, digits every key shares are skipped so most frames only sort the low order bits!!
+RenderSortEntry * radix_sort_render_entries(RenderSortEntry * entries, RenderSortEntry * temp, u32 count) {
+	DEBUG_TIME_BLOCK();
+
+	RenderSortEntry * src = entries;
+	RenderSortEntry * dst = temp;
+
+	for(u32 shift = 0; shift < 64 && count; shift += 8) {
+		u32 offsets[256] = {};
+		for(u32 i = 0; i < count; i++) {
+			offsets[(src[i].key >> shift) & 0xFF]++;
+		}
+
+		if(offsets[(src[0].key >> shift) & 0xFF] != count) {
+			u32 offset = 0;
+			for(u32 i = 0; i < ARRAY_COUNT(offsets); i++) {
+				u32 digit_count = offsets[i];
+				offsets[i] = offset;
+				offset += digit_count;
+			}
+
+			for(u32 i = 0; i < count; i++) {
+				dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+			}
+
+			RenderSortEntry * swap = src;
+			src = dst;
+			dst = swap;
+		}
+	}
+
+	return src;
+}
+
 RenderElement * push_render_elem(RenderGroup * render_group, Asset * asset, math::Vec3 pos, math::Vec2 dim, f32 angle, math::Vec4 color, b32 scrollable = false) {
 	DEBUG_TIME_BLOCK();
 
@@ -421,28 +869,41 @@ RenderElement * push_render_elem(RenderGroup * render_group, Asset * asset, math
 	ASSERT(asset);
 	ASSERT(render_group->elem_count < render_group->max_elem_count);
 
-	math::Vec2 pos2 = project_pos(&render_group->transform, pos);
-
-	//TODO: Need to do an AABB test now that we have rotation!!
 	b32 culled = true;
+	math::Vec2 pos2 = math::vec2(0.0f);
 	if(color.a > 0.0f) {
+		pos2 = project_pos(&render_group->transform, pos);
+
+		//NOTE: Scrollable textures repeat once either side along their x axis!!
+		math::Vec2 bounds_dim = dim;
+		if(scrollable) {
+			bounds_dim.x *= 3.0f;
+		}
+
 		if(asset->type == AssetType_texture) {
 			//TODO: Remove epsilon!!
 			f32 epsilon = 0.1f;
-			if(math::rec_overlap(render_group->projection_bounds, math::rec2_pos_dim(pos2, dim * (1.0f + epsilon)))) {
-				culled = false;
-			}
+			bounds_dim *= 1.0f + epsilon;
 		}
-		else {
-			if(math::rec_overlap(render_group->projection_bounds, math::rec2_pos_dim(pos2, dim))) {
-				culled = false;
-			}
+
+		//NOTE: AABB of the rotated quad!!
+		if(angle != 0.0f) {
+			f32 c = math::abs(math::cos(angle));
+			f32 s = math::abs(math::sin(angle));
+			bounds_dim = math::vec2(c * bounds_dim.x + s * bounds_dim.y, s * bounds_dim.x + c * bounds_dim.y);
+		}
+
+		if(math::rec_overlap(render_group->projection_bounds, math::rec2_pos_dim(pos2, bounds_dim))) {
+			culled = false;
 		}
 	}
 
 	RenderElement * elem = 0;
 	if(!culled) {
-		elem = render_group->elems + render_group->elem_count++;
+		u32 order = render_group->elem_count++;
+
+		elem = render_group->elems + order;
+		elem->sort_key = get_render_sort_key(render_group->layer, pos.z, get_render_batch_id(render_group->assets, asset), order);
 		elem->pos = pos2;
 		elem->dim = dim;
 		elem->color = color;
@@ -450,6 +911,9 @@ RenderElement * push_render_elem(RenderGroup * render_group, Asset * asset, math
 		elem->scrollable = scrollable;
 		elem->asset = asset;
 	}
+	else {
+		render_group->debug_culled_count++;
+	}
 
 	return elem;
 }
@@ -549,7 +1013,8 @@ void push_str_to_render_group(RenderGroup * render_group, Font * font, FontLayou
 					align.y = (i32)align.y;
 				}
 
-				push_render_elem(render_group, asset, math::vec3(align + sprite->offset * layout->scale, 0.0f), sprite->dim * layout->scale, 0.0f, color);
+				f32 glyph_scale = layout->scale * font->glyph_scale;
+				push_render_elem(render_group, asset, math::vec3(align + sprite->offset * glyph_scale, 0.0f), sprite->dim * glyph_scale, 0.0f, color);
 
 				layout->pos.x += font->glyphs[glyph_index].advance * layout->scale;
 			}
@@ -579,57 +1044,85 @@ void render_and_clear_render_group(RenderState * render_state, RenderGroup * ren
 		0.0f, 0.0f, 1.0f,
 	};
 
-	u32 null_atlas_index = U32_MAX;
-	u32 current_atlas_index = null_atlas_index;
 	RenderBatch * render_batch = render_state->render_batch;
-	ASSERT(!render_batch->e);
+	ASSERT(!render_batch->e && !render_batch->instance_e);
 	render_batch->mode = RenderMode_triangles;
+	render_batch->instanced = false;
+	render_batch->tex = 0;
 
 	Shader * basic_shader = &render_state->basic_shader;
 
-	for(u32 i = 0; i < render_group->elem_count; i++) {
-		RenderElement * elem = render_group->elems + i;
-		Asset * asset = elem->asset;
+	f32 pixels_per_unit = (f32)render_state->render_width / (f32)render_transform->projection_width;
 
-		if(asset->type == AssetType_texture) {
-			Texture * tex = &asset->texture;
+	for(u32 i = 0; i < render_group->elem_count; i++) {
+		RenderSortEntry * entry = render_group->sort_entries + i;
+		entry->key = render_group->elems[i].sort_key;
+		entry->index = i;
+	}
 
-			if(current_atlas_index != null_atlas_index) {
-				render_and_clear_render_batch(render_batch, basic_shader, &projection);
-				current_atlas_index = null_atlas_index;
-			}
+	RenderSortEntry * sorted_entries = radix_sort_render_entries(render_group->sort_entries, render_group->sort_temp, render_group->elem_count);
 
-			f32 sin_a = math::sin(elem->angle);
-			f32 cos_a = math::cos(elem->angle);
+	//NOTE: Only what actually reaches the batch, elements waiting on a texture upload aren't drawn!!
+	u32 drawn_count = 0;
 
-			//NOTE: Combined transform matrix = proj * translate * rotate * scale!!
-			math::Mat3 transform = {
-				 elem->dim.x * cos_a * proj_x, elem->dim.x * sin_a * proj_y, 0.0f,
-				-elem->dim.y * sin_a * proj_x, elem->dim.y * cos_a * proj_y, 0.0f,
-				 elem->pos.x * proj_x, elem->pos.y * proj_y, 1.0f,
-			};
+	for(u32 i = 0; i < render_group->elem_count; i++) {
+		RenderElement * elem = render_group->elems + sorted_entries[i].index;
+		Asset * asset = elem->asset;
 
-			gl::VertexBuffer * v_buf = elem->scrollable ? &render_state->scrollable_quad_v_buf : &render_state->quad_v_buf;
-			render_v_buf(v_buf, RenderMode_triangles, basic_shader, &transform, tex, elem->color);
+		Texture * tex = 0;
+		u32 vert_count = 0;
+		b32 instanced = false;
+		if(asset->type == AssetType_texture) {
+			tex = &asset->texture;
+			vert_count = elem->scrollable ? QUAD_VERT_COUNT * 3 : QUAD_VERT_COUNT;
+			instanced = render_batch->instance_len > 0;
 		}
 		else {
-			Texture * sprite = &asset->sprite;
+			tex = get_texture_asset(render_state->assets, AssetId_atlas, asset->sprite.atlas_index);
+			vert_count = get_sprite_vert_count(&asset->sprite);
+			instanced = render_batch->instance_len > 0 && !asset->sprite.mesh_vert_count;
+		}
+
+		//NOTE: Textures still in the upload queue are skipped rather than drawn half uploaded!!
+		if(texture_is_ready(render_state->assets, asset)) {
+			//NOTE: Every quad is one instance, so the vert count over a quad's is the instance count!!
+			u32 remaining = instanced ? (render_batch->instance_len - render_batch->instance_e) * QUAD_VERT_COUNT : render_batch->v_len - render_batch->e;
 
-			u32 elems_remaining = render_batch->v_len - render_batch->e;
-			if(current_atlas_index != sprite->atlas_index || elems_remaining < QUAD_ELEM_COUNT) {
+			//NOTE: Aliased textures are separate assets that share a GL texture, so batch on that!!
+			if(!render_batch->tex || render_batch->tex->gl_id != tex->gl_id || render_batch->instanced != instanced || remaining < vert_count) {
 				render_and_clear_render_batch(render_batch, basic_shader, &projection);
+				render_batch->tex = tex;
+				render_batch->instanced = instanced;
+			}
+
+			if(tex->sdf) {
+				//NOTE: Half a screen pixel either side of the edge, so text at a different scale needs its own batch!!
+				f32 pixels_per_texel = (elem->dim.x / asset->sprite.dim.x) * pixels_per_unit;
+				f32 sdf_edge = 0.25f / (FONT_SDF_SPREAD_PIXELS * pixels_per_texel);
+				if((render_batch->e || render_batch->instance_e) && render_batch->sdf_edge != sdf_edge) {
+					render_and_clear_render_batch(render_batch, basic_shader, &projection);
+				}
 
-				current_atlas_index = sprite->atlas_index;
-				render_batch->tex = get_texture_asset(render_state->assets, AssetId_atlas, sprite->atlas_index);
+				render_batch->sdf_edge = sdf_edge;
 			}
 
-			push_sprite_to_batch(render_batch, sprite, elem->pos, elem->dim, elem->angle, elem->color);
+			if(asset->type == AssetType_texture) {
+				push_texture_to_batch(render_batch, elem->pos, elem->dim, elem->angle, elem->color, elem->scrollable);
+			}
+			else {
+				push_sprite_to_batch(render_batch, &asset->sprite, elem->pos, elem->dim, elem->angle, elem->color);
+			}
+
+			drawn_count++;
 		}
 	}
 
-	if(current_atlas_index != null_atlas_index) {
-		render_and_clear_render_batch(render_batch, basic_shader, &projection);
-	}
+	render_and_clear_render_batch(render_batch, basic_shader, &projection);
+
+	render_state->debug_frame_culled_count += render_group->debug_culled_count;
+	render_state->debug_frame_drawn_count += drawn_count;
 
 	render_group->elem_count = 0;
+	render_group->layer = 0;
+	render_group->debug_culled_count = 0;
 }
\ No newline at end of file
@@ -4,9 +4,33 @@
 
 #include <gl.hpp>
 
-#define VERT_ELEM_COUNT 8
-#define QUAD_ELEM_COUNT (VERT_ELEM_COUNT * 6)
-#define QUAD_LINES_ELEM_COUNT (VERT_ELEM_COUNT * 8)
+//NOTE: Triangle batches are indexed, every 4 verts are a quad drawn as (0, 1, 2) and (0, 3, 1)!!
+#define QUAD_VERT_COUNT 4
+#define QUAD_INDEX_COUNT 6
+#define QUAD_LINES_VERT_COUNT 8
+#define SPRITE_MAX_VERT_COUNT (((SPRITE_MAX_MESH_VERTS - 1) / 2) * QUAD_VERT_COUNT)
+#define RENDER_BATCH_MAX_VERTS (QUAD_VERT_COUNT * 768)
+//NOTE: The batch's GPU buffer holds this many full batches before it gets orphaned!!
+#define RENDER_BATCH_RING_SEGMENTS 4
+#define RENDER_BATCH_MAX_INSTANCES 768
+
+//NOTE: The scene renders into a corner of the frame buffer that shrinks when frames run long, the post pass scales it back up!!
+#define RENDER_SCALE_MIN 0.5f
+#define RENDER_SCALE_MAX 1.0f
+#define RENDER_SCALE_STEP 0.125f
+//NOTE: The target is the refresh interval as observed, it snaps down to faster frames and only creeps back up at this rate per second while at full scale with no drop pending!!
+#define RENDER_SCALE_REFRESH_RISE_RATE 0.1f
+//NOTE: Drop above the first, raise below the second, the gap in between is the hysteresis!!
+#define RENDER_SCALE_DROP_THRESHOLD 1.2f
+#define RENDER_SCALE_RAISE_THRESHOLD 1.05f
+#define RENDER_SCALE_DROP_HOLD_TIME 0.5f
+#define RENDER_SCALE_RAISE_HOLD_TIME 2.0f
+#define RENDER_SCALE_COOLDOWN_TIME 1.0f
+//NOTE: Going back up to a scale that had to be dropped waits this long, doubling each time it fails again!!
+#define RENDER_SCALE_RETRY_HOLD_TIME 8.0f
+#define RENDER_SCALE_MAX_RETRY_HOLD_TIME 64.0f
+//NOTE: Longer frames are hitches (or a tab switch) rather than fill cost!!
+#define RENDER_SCALE_MAX_FRAME_TIME 0.25f
 
 //TODO: Automatically generate these structs for shaders!!
 struct Shader {
@@ -16,13 +40,37 @@ struct Shader {
 	u32 i_tex_coord;
 	u32 i_color;
 
+	//NOTE: Instanced sprites, i_position and i_color are per instance there!!
+	u32 i_corner;
+	u32 i_dim;
+	u32 i_angle;
+	u32 i_uv_rect;
+
 	u32 transform;
 	u32 color;
 	u32 tex0;
+	u32 sdf_edge;
 
 	u32 pixelate_scale;
 	u32 pixelate_dim;
 	u32 brightness;
+	u32 uv_scale;
+};
+
+//NOTE: 16 bytes, uvs are normalized u16s and color is premultiplied RGBA8!!
+struct Vertex {
+	math::Vec2 pos;
+	u16 uv[2];
+	u32 color;
+};
+
+//NOTE: 32 bytes, one per sprite when instancing, the vertex shader builds the corners!!
+struct SpriteInstance {
+	math::Vec2 pos;
+	math::Vec2 dim;
+	f32 angle;
+	u16 uv[4];
+	u32 color;
 };
 
 enum RenderMode {
@@ -34,13 +82,36 @@ enum RenderMode {
 
 struct RenderBatch {
 	Texture * tex;
+	f32 sdf_edge;
 
+	//NOTE: In verts!!
 	u32 v_len;
-	f32 * v_arr;
-	gl::VertexBuffer v_buf;
+	Vertex * v_arr;
 	u32 e;
 
+	//NOTE: Flushes are appended to v_buf at ring_pos (in verts) so a draw never overwrites one still in flight!!
+	gl::VertexBuffer v_buf;
+	u32 ring_pos;
+
+	//NOTE: Shared and static, covers the whole ring!!
+	gl::IndexBuffer * i_buf;
+
 	RenderMode mode;
+
+	//NOTE: Quads can go in as instances instead, a batch holds one or the other and instance_len is 0 when unsupported!!
+	b32 instanced;
+	u32 instance_len;
+	SpriteInstance * instance_arr;
+	u32 instance_e;
+
+	gl::VertexBuffer instance_buf;
+	u32 instance_ring_pos;
+
+	Shader * instance_shader;
+	gl::VertexBuffer * corner_v_buf;
+
+	u32 debug_draw_call_count;
+	u32 debug_bytes_uploaded;
 };
 
 struct RenderTransform {
@@ -52,7 +123,20 @@ struct RenderTransform {
 	u32 projection_height;
 };
 
+//NOTE: Sort keys, most significant first, elements only reorder by texture within the same layer and z!!
+#define RENDER_SORT_LAYER_BITS 8
+#define RENDER_SORT_DEPTH_BITS 16
+#define RENDER_SORT_BATCH_BITS 16
+#define RENDER_SORT_ORDER_BITS 24
+
+struct RenderSortEntry {
+	u64 key;
+	u32 index;
+};
+
 struct RenderElement {
+	u64 sort_key;
+
 	math::Vec2 pos;
 	math::Vec2 dim;
 	math::Vec4 color;
@@ -68,10 +152,18 @@ struct RenderGroup {
 	u32 elem_count;
 	RenderElement * elems;
 
+	//NOTE: Layer for everything pushed from here on, back to 0 when the group is cleared!!
+	u32 layer;
+	RenderSortEntry * sort_entries;
+	RenderSortEntry * sort_temp;
+
 	AssetState * assets;
 
 	RenderTransform transform;
 	math::Rec2 projection_bounds;
+
+	//NOTE: Anything skipped before it got an element counts too!!
+	u32 debug_culled_count;
 };
 
 enum FontLayoutAnchor {
@@ -104,18 +196,45 @@ struct RenderState {
 	u32 screen_height;
 
 	Shader basic_shader;
+	Shader sprite_shader;
 	Shader post_shader;
 
+	b32 instancing;
+
 	gl::FrameBuffer frame_buffer;
 	gl::VertexBuffer screen_quad_v_buf;
-
-	gl::VertexBuffer quad_v_buf;
-	gl::VertexBuffer scrollable_quad_v_buf;
+	gl::IndexBuffer quad_i_buf;
+	gl::VertexBuffer quad_corner_v_buf;
 
 	f32 pixelate_time;
 	f32 fade_amount;
+	b32 post_filter;
+
+	f32 render_scale;
+	u32 render_width;
+	u32 render_height;
+
+	f32 render_scale_frame_time;
+	f32 render_scale_refresh_time;
+	i32 render_scale_direction;
+	f32 render_scale_hold_time;
+	f32 render_scale_cooldown;
+	f32 render_scale_failed;
+	f32 render_scale_retry_hold_time;
 
 	RenderBatch * render_batch;
+
+	//NOTE: Totals for the last finished frame!!
+	u32 debug_draw_call_count;
+	u32 debug_gl_calls_made;
+	u32 debug_gl_calls_skipped;
+	u32 debug_bytes_uploaded;
+	u32 debug_culled_count;
+	u32 debug_drawn_count;
+	u32 debug_post_filter_pixels_saved;
+
+	u32 debug_frame_culled_count;
+	u32 debug_frame_drawn_count;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+char const * SPRITE_VERT_SRC = STRINGIFY_GLSL_SHADER(100,
+
+attribute vec2 i_corner;
+
+attribute vec2 i_position;
+attribute vec2 i_dim;
+attribute float i_angle;
+attribute vec4 i_uv_rect;
+attribute vec4 i_color;
+
+uniform mat3 transform;
+uniform vec4 color;
+
+varying vec2 tex_coord;
+varying vec4 vert_color;
+
+void main() {
+	//NOTE: Same corners as the CPU path, the corner is in [0, 1] and the instance is centred on i_position!!
+	vec2 x_axis = vec2(cos(i_angle), sin(i_angle));
+	vec2 y_axis = vec2(-x_axis.y, x_axis.x);
+	vec2 offset = (i_corner - 0.5) * i_dim;
+	vec2 position = i_position + x_axis * offset.x + y_axis * offset.y;
+
+	gl_Position = vec4(transform * vec3(position, 1.0), 1.0);
+	tex_coord = mix(i_uv_rect.xy, i_uv_rect.zw, i_corner);
+	vert_color = i_color * color;
+}
+
+);
@@ -44,6 +44,7 @@
 #endif
 
 #define ARRAY_COUNT(x) (sizeof((x)) / sizeof((x)[0]))
+#define OFFSET_OF(type, member) ((size_t)&(((type *)0)->member))
 
 #define KILOBYTES(x) (1024 * (x))
 #define MEGABYTES(x) (1024 * KILOBYTES(x))